@@ -0,0 +1,492 @@
+// Event path micro-benchmarks. Every case reports ns per operation and heap allocations per
+// operation, and the process exits with 1 if a case allocates or is slower than its threshold, so
+// CI can run it after every change to PollEvents. Cases that need an X server are skipped without
+// one; in CI run the suite under Xvfb, e.g. `xvfb-run -a ./NovaBench --xtest`.
+//
+// The thresholds assume an optimised build (Release or RelWithDebInfo). Built without optimisation,
+// e.g. a default configure without CMAKE_BUILD_TYPE, the timings are still reported but only the
+// allocation checks can fail the run.
+//
+// Usage: NovaBench [--threshold-scale <factor>] [--no-x11] [--xtest]
+//   --threshold-scale  multiplies every threshold, for slow or shared CI machines
+//   --no-x11           skip the cases that open a display
+//   --xtest            also run the XTest case, which types and moves the pointer on the server.
+//                      Only pass it for a private server like Xvfb, never in a desktop session.
+#include <Nova/Nova.hpp>
+#include <Flux/Flux.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+#ifdef NOVA_BENCH_XTEST
+#include <X11/extensions/XTest.h>
+#endif
+
+// Count every C++ heap allocation so the event path can be checked for allocations per operation
+static std::atomic<size_t> allocationCount{0};
+
+void *operator new(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+#ifdef __OPTIMIZE__
+static constexpr bool checkThresholds = true;
+#else
+static constexpr bool checkThresholds = false;
+#endif
+
+// Written by every case so the compiler cannot drop the measured work
+static volatile size_t sink = 0;
+
+class BenchResult
+{
+public:
+    const char *name = "";
+    size_t operations = 0;
+    double nsPerOperation = 0.0;
+    double allocationsPerOperation = 0.0;
+    double thresholdNs = 0.0;
+};
+
+static std::vector<BenchResult> results;
+
+/// @brief Runs setup(round) and body(round) once to warm up, then rounds more times. body returns
+/// how many operations the round performed, only the time spent inside body is counted.
+template <typename Setup, typename Body>
+static void Measure(const char *name, int rounds, double thresholdNs, Setup &&setup, Body &&body)
+{
+    setup(0);
+    body(0);
+
+    size_t operations = 0;
+    size_t allocations = 0;
+    std::chrono::nanoseconds elapsed{0};
+
+    for (int round = 1; round <= rounds; round++)
+    {
+        setup(round);
+
+        size_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+
+        operations += body(round);
+
+        elapsed += std::chrono::steady_clock::now() - start;
+        allocations += allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.operations = operations;
+    result.nsPerOperation = operations ? static_cast<double>(elapsed.count()) / operations : 0.0;
+    result.allocationsPerOperation = operations ? static_cast<double>(allocations) / operations : 0.0;
+    result.thresholdNs = thresholdNs;
+    results.push_back(result);
+}
+
+template <typename Body>
+static void Measure(const char *name, int rounds, double thresholdNs, Body &&body)
+{
+    Measure(name, rounds, thresholdNs, [](int) {}, std::forward<Body>(body));
+}
+
+static const KeySym benchKeySyms[] = {
+    XK_a, XK_z, XK_A, XK_0, XK_9, XK_space, XK_Return, XK_Escape, XK_BackSpace, XK_Tab,
+    XK_Shift_L, XK_Control_R, XK_Alt_L, XK_Super_L, XK_Left, XK_Up, XK_Home, XK_Page_Down,
+    XK_F1, XK_F12, XK_KP_0, XK_KP_Enter, XK_minus, XK_bracketleft, XK_grave, XK_Num_Lock,
+    XK_Caps_Lock, XK_Insert, XK_Delete, XK_Print, XK_Menu, 0x12345678,
+};
+
+static const Key benchKeys[] = {
+    Key::KEY_A, Key::KEY_Q, Key::KEY_Z, Key::KEY__0, Key::KEY__7,
+    Key::KEY_SPACE, Key::KEY_RETURN, Key::KEY_MINUS, Key::KEY_SLASH,
+    Key::KEY_LEFTBRACKET, Key::KEY_LSHIFT, Key::KEY_LEFT, Key::KEY_F5,
+    Key::KEY_KP_5, Key::KEY_ESCAPE, Key::KEY_GRAVE,
+};
+
+static constexpr size_t benchKeySymCount = sizeof(benchKeySyms) / sizeof(benchKeySyms[0]);
+static constexpr size_t benchKeyCount = sizeof(benchKeys) / sizeof(benchKeys[0]);
+
+// Matches the capacity of Window's event queue, so one round fills it without dropping events
+static constexpr size_t benchQueueSize = 1024;
+
+static void BenchKeySymTranslation()
+{
+    const size_t iterations = 4096;
+
+    Measure("X11KeySymToNovaKey", 100, 20.0, [&](int)
+    {
+        size_t result = 0;
+        for (size_t i = 0; i < iterations; i++)
+        {
+            result += static_cast<size_t>(Nova::X11KeySymToNovaKey(benchKeySyms[i % benchKeySymCount]));
+        }
+        sink = sink + result;
+        return iterations;
+    });
+}
+
+static void BenchKeyToChar()
+{
+    const size_t iterations = 4096;
+
+    Measure("KeyToChar", 100, 20.0, [&](int)
+    {
+        size_t result = 0;
+        for (size_t i = 0; i < iterations; i++)
+        {
+            std::optional<char> c = KeyToChar(benchKeys[i % benchKeyCount], (i & 1) != 0);
+            result += c ? static_cast<size_t>(*c) : 0;
+        }
+        sink = sink + result;
+        return iterations;
+    });
+}
+
+static void BenchKeyboardState()
+{
+    const size_t iterations = 4096;
+    Nova::KeyboardState state;
+
+    Measure("KeyboardState Set/Test/Reset", 100, 10.0, [&](int)
+    {
+        size_t result = 0;
+        for (size_t i = 0; i < iterations; i++)
+        {
+            Key key = benchKeys[i % benchKeyCount];
+            state.Set(key);
+            result += state.Test(key);
+            state.Reset(key);
+        }
+        sink = sink + result + state.Any();
+        return iterations;
+    });
+}
+
+static void BenchRingBuffer()
+{
+    const size_t capacity = benchQueueSize;
+    Nova::RingBuffer<Nova::Event> ring(capacity);
+
+    Measure("RingBuffer<Event> push/pop", 100, 30.0, [&](int round)
+    {
+        Nova::MouseMoveEvent move;
+        for (size_t i = 0; i < capacity; i++)
+        {
+            move.x = static_cast<int>(i);
+            move.y = round;
+            ring.Push(move);
+        }
+
+        size_t result = 0;
+        Nova::Event event;
+        while (ring.Pop(event))
+        {
+            result += event.index();
+        }
+        sink = sink + result;
+        return capacity;
+    });
+}
+
+// A few hundred bindings, mostly plain keys plus some chords, resolved on every key change
+static void BenchActionMap()
+{
+    Nova::ActionMap map;
+    for (Nova::ActionId action = 0; action < 300; action++)
+    {
+        Key key = static_cast<Key>(static_cast<int>(Key::KEY_A) + action % 100);
+        uint16_t modifiers = action % 10 == 0 ? static_cast<uint16_t>(Nova::Modifier::Ctrl) : 0;
+        map.BindKey(action, key, modifiers);
+    }
+    map.Compile();
+
+    Nova::KeyboardState keys;
+    const size_t iterations = 4096;
+
+    Measure("ActionMap KeyChanged", 100, 100.0, [&](int)
+    {
+        for (size_t i = 0; i < iterations; i++)
+        {
+            Key key = benchKeys[(i / 2) % benchKeyCount];
+            if (i & 1)
+            {
+                keys.Reset(key);
+            }
+            else
+            {
+                keys.Set(key);
+            }
+            map.KeyChanged(key, keys);
+            map.ClearChanges();
+        }
+        sink = sink + map.IsDown(0);
+        return iterations;
+    });
+}
+
+// Injected through the headless backend, so this is DispatchEvent, the key state updates and the
+// queue without any display connection
+static void BenchHeadlessPipeline()
+{
+    Nova::Window window("NovaBench", 1280, 720, Nova::Backend::Headless);
+    const size_t eventsPerRound = benchQueueSize;
+
+    std::vector<Nova::Event> events;
+    events.reserve(eventsPerRound);
+    for (size_t i = 0; i < eventsPerRound; i++)
+    {
+        Key key = benchKeys[(i / 2) % benchKeyCount];
+        if (i % 4 == 3)
+        {
+            Nova::MouseMoveEvent move;
+            move.x = static_cast<int>(i % 1280);
+            move.y = static_cast<int>(i % 720);
+            events.push_back(move);
+        }
+        else if (i % 2 == 0)
+        {
+            Nova::KeyDownEvent down;
+            down.key = key;
+            events.push_back(down);
+        }
+        else
+        {
+            Nova::KeyUpEvent up;
+            up.key = key;
+            events.push_back(up);
+        }
+    }
+
+    Measure("Inject/PollEvents/PopEvent", 200, 150.0, [&](int)
+    {
+        for (const Nova::Event &event : events)
+        {
+            window.InjectEvent(event);
+        }
+
+        window.PollEvents();
+
+        size_t result = window.IsKeyDown(Key::KEY_A);
+        size_t popped = 0;
+        while (std::optional<Nova::Event> event = window.PopEvent())
+        {
+            result += event->index();
+            popped++;
+        }
+        sink = sink + result;
+        return popped;
+    });
+
+    // A touchpad flick: every sample of the poll is summed into one MouseScrollEvent
+    Nova::MouseScrollEvent scroll;
+    scroll.deltaY = 0.25;
+    scroll.precise = true;
+
+    Measure("Scroll accumulation", 200, 100.0, [&](int)
+    {
+        for (size_t i = 0; i < eventsPerRound; i++)
+        {
+            window.InjectEvent(scroll);
+        }
+
+        window.PollEvents();
+
+        double result = 0.0;
+        while (std::optional<Nova::Event> event = window.PopEvent())
+        {
+            if (const Nova::MouseScrollEvent *accumulated = std::get_if<Nova::MouseScrollEvent>(&*event))
+            {
+                result += accumulated->deltaY;
+            }
+        }
+        sink = sink + static_cast<size_t>(result);
+        return eventsPerRound;
+    });
+}
+
+#ifdef NOVA_BENCH_XTEST
+// Real input generated by the server through XTest, so the measurement includes the socket read
+// and Xlib's event parsing. The events are flushed and synced before the clock starts.
+static void InjectServerInput(Display *display, int count, int round)
+{
+    int screen = DefaultScreen(display);
+    for (int i = 0; i < count; i++)
+    {
+        if (i % 8 == 7)
+        {
+            KeyCode keycode = XKeysymToKeycode(display, benchKeySyms[(round + i) % 10]);
+            XTestFakeKeyEvent(display, keycode, True, CurrentTime);
+            XTestFakeKeyEvent(display, keycode, False, CurrentTime);
+        }
+        else
+        {
+            XTestFakeMotionEvent(display, screen, 200 + (round + i) % 800, 200 + (round * 3 + i) % 400, CurrentTime);
+        }
+    }
+    XSync(display, False);
+}
+#endif
+
+// Puts synthetic motion events straight into Xlib's local queue, so no server round trip is measured
+static void InjectMotionStorm(const Nova::X11Handles &handles, int count, int frame)
+{
+    for (int i = 0; i < count; i++)
+    {
+        XEvent event = {};
+        event.type = MotionNotify;
+        event.xmotion.display = handles.display;
+        event.xmotion.window = handles.window;
+        event.xmotion.x = (frame + i) % 1280;
+        event.xmotion.y = (frame * 3 + i) % 720;
+        XPutBackEvent(handles.display, &event);
+    }
+}
+
+static size_t DrainEvents(Nova::Window &window)
+{
+    window.PollEvents();
+
+    size_t popped = 0;
+    while (window.PopEvent())
+    {
+        popped++;
+    }
+    return popped;
+}
+
+static Bool IsMapNotify(Display *, XEvent *event, XPointer window)
+{
+    return event->type == MapNotify && event->xmap.window == *reinterpret_cast<X11Window *>(window);
+}
+
+static void BenchX11(bool xtest)
+{
+    const int eventsPerFrame = 500;
+
+    Nova::Window window("NovaBench", 1280, 720, Nova::Backend::X11);
+    if (!window.IsValid() || window.backend != Nova::Backend::X11)
+    {
+        Flux::Info("No X server, skipping the X11 cases");
+        return;
+    }
+
+    Nova::X11Handles handles = std::get<Nova::X11Handles>(window.GetNativeHandles());
+
+    // Focus can only be set on a viewable window, so wait for the map before anything is drained
+    XEvent mapped;
+    XIfEvent(handles.display, &mapped, IsMapNotify, reinterpret_cast<XPointer>(&handles.window));
+    DrainEvents(window);
+
+    Measure("X11 motion storm (XPutBackEvent)", 1000, 400.0,
+            [&](int frame) { InjectMotionStorm(handles, eventsPerFrame, frame); },
+            [&](int) { return DrainEvents(window); });
+
+#ifdef NOVA_BENCH_XTEST
+    if (!xtest)
+    {
+        Flux::Info("Skipping the XTest case, pass --xtest to run it on a private X server");
+        return;
+    }
+
+    int eventBase, errorBase, major, minor;
+    if (!XTestQueryExtension(handles.display, &eventBase, &errorBase, &major, &minor))
+    {
+        Flux::Info("XTest not available, skipping the synthetic server input case");
+        return;
+    }
+
+    XSetInputFocus(handles.display, handles.window, RevertToParent, CurrentTime);
+
+    Measure("X11 XTest input", 200, 2000.0,
+            [&](int frame) { InjectServerInput(handles.display, eventsPerFrame, frame); },
+            [&](int) { return DrainEvents(window); });
+#else
+    (void)xtest;
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    double thresholdScale = 1.0;
+    bool runX11 = true;
+    bool runXTest = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--threshold-scale") == 0 && i + 1 < argc)
+        {
+            thresholdScale = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--no-x11") == 0)
+        {
+            runX11 = false;
+        }
+        else if (std::strcmp(argv[i], "--xtest") == 0)
+        {
+            runXTest = true;
+        }
+        else
+        {
+            Flux::Error("Unknown argument {}", argv[i]);
+            return 2;
+        }
+    }
+
+    BenchKeySymTranslation();
+    BenchKeyToChar();
+    BenchKeyboardState();
+    BenchRingBuffer();
+    BenchActionMap();
+    BenchHeadlessPipeline();
+    if (runX11)
+    {
+        BenchX11(runXTest);
+    }
+
+    if (!checkThresholds)
+    {
+        Flux::Info("Unoptimised build, timings are reported but not checked against their thresholds");
+    }
+
+    bool failed = false;
+    for (const BenchResult &result : results)
+    {
+        double threshold = result.thresholdNs * thresholdScale;
+        Flux::Info("{}: {} ops, {} ns/op (limit {}), {} allocations/op", result.name, result.operations,
+                   result.nsPerOperation, threshold, result.allocationsPerOperation);
+
+        if (result.allocationsPerOperation > 0.0)
+        {
+            Flux::Error("{} allocated on the event path", result.name);
+            failed = true;
+        }
+        if (checkThresholds && result.nsPerOperation > threshold)
+        {
+            Flux::Error("{} exceeded its threshold of {} ns/op", result.name, threshold);
+            failed = true;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,272 @@
+#include <Nova/Actions.hpp>
+
+namespace Nova
+{
+    static constexpr uint16_t ChordModifiers = static_cast<uint16_t>(Modifier::Shift) | static_cast<uint16_t>(Modifier::Ctrl) |
+                                               static_cast<uint16_t>(Modifier::Alt) | static_cast<uint16_t>(Modifier::Super);
+
+    static KeyboardState KeysOf(Key left, Key right)
+    {
+        KeyboardState state;
+        state.Set(left);
+        state.Set(right);
+        return state;
+    }
+
+    static const KeyboardState shiftKeys = KeysOf(Key::KEY_LSHIFT, Key::KEY_RSHIFT);
+    static const KeyboardState ctrlKeys = KeysOf(Key::KEY_LCTRL, Key::KEY_RCTRL);
+    static const KeyboardState altKeys = KeysOf(Key::KEY_LALT, Key::KEY_RALT);
+    static const KeyboardState superKeys = KeysOf(Key::KEY_LGUI, Key::KEY_RGUI);
+    static const KeyboardState modifierKeys = shiftKeys | ctrlKeys | altKeys | superKeys;
+
+    // Taken from the key state instead of event modifiers, so a chord follows the modifier keys
+    // themselves and both paths agree
+    static uint16_t HeldModifiers(const KeyboardState &keys)
+    {
+        uint16_t modifiers = 0;
+        modifiers |= keys.Intersects(shiftKeys) ? static_cast<uint16_t>(Modifier::Shift) : 0;
+        modifiers |= keys.Intersects(ctrlKeys) ? static_cast<uint16_t>(Modifier::Ctrl) : 0;
+        modifiers |= keys.Intersects(altKeys) ? static_cast<uint16_t>(Modifier::Alt) : 0;
+        modifiers |= keys.Intersects(superKeys) ? static_cast<uint16_t>(Modifier::Super) : 0;
+        return modifiers;
+    }
+
+    void ActionMap::BindKey(ActionId action, Key key, uint16_t modifiers, float value)
+    {
+        Binding binding;
+        binding.action = action;
+        binding.key = key;
+        binding.modifiers = modifiers & ChordModifiers;
+        binding.value = value;
+        bindings.push_back(binding);
+        compiled = false;
+    }
+
+    void ActionMap::BindAxis(ActionId action, Key negative, Key positive)
+    {
+        BindKey(action, negative, 0, -1.0f);
+        BindKey(action, positive, 0, 1.0f);
+    }
+
+    void ActionMap::BindMouseButton(ActionId action, MouseButton button, float value)
+    {
+        Binding binding;
+        binding.action = action;
+        binding.button = button;
+        binding.isButton = true;
+        binding.value = value;
+        bindings.push_back(binding);
+        compiled = false;
+    }
+
+    void ActionMap::Compile()
+    {
+        size_t keyCount = static_cast<size_t>(Key::KEY_NUM_SCANCODES);
+        size_t actionCount = 0;
+        for (const Binding &binding : bindings)
+        {
+            if (binding.action + size_t(1) > actionCount)
+            {
+                actionCount = binding.action + size_t(1);
+            }
+        }
+
+        // Counting sort of the binding indices by key and by action
+        keyOffsets.assign(keyCount + 1, 0);
+        actionOffsets.assign(actionCount + 1, 0);
+        buttonBindings.clear();
+        for (uint32_t i = 0; i < bindings.size(); i++)
+        {
+            if (bindings[i].isButton)
+            {
+                buttonBindings.push_back(i);
+            }
+            else
+            {
+                keyOffsets[static_cast<size_t>(bindings[i].key) + 1]++;
+            }
+            actionOffsets[bindings[i].action + 1]++;
+        }
+        for (size_t i = 0; i < keyCount; i++)
+        {
+            keyOffsets[i + 1] += keyOffsets[i];
+        }
+        for (size_t i = 0; i < actionCount; i++)
+        {
+            actionOffsets[i + 1] += actionOffsets[i];
+        }
+
+        keyBindings.assign(keyOffsets[keyCount], 0);
+        actionBindings.assign(actionOffsets[actionCount], 0);
+        std::vector<uint32_t> keyFill(keyOffsets.begin(), keyOffsets.end() - 1);
+        std::vector<uint32_t> actionFill(actionOffsets.begin(), actionOffsets.end() - 1);
+
+        KeyboardState chordKeys;
+        for (uint32_t i = 0; i < bindings.size(); i++)
+        {
+            const Binding &binding = bindings[i];
+            if (!binding.isButton)
+            {
+                keyBindings[keyFill[static_cast<size_t>(binding.key)]++] = i;
+                if (binding.modifiers != 0)
+                {
+                    chordKeys.Set(binding.key);
+                }
+            }
+            actionBindings[actionFill[binding.action]++] = i;
+        }
+
+        simple.assign(actionCount, 1);
+        simpleKeys.assign(actionCount, KeyboardState());
+        chordActions.clear();
+        for (ActionId action = 0; action < actionCount; action++)
+        {
+            bool chord = false;
+            for (uint32_t i = actionOffsets[action]; i < actionOffsets[action + 1]; i++)
+            {
+                const Binding &binding = bindings[actionBindings[i]];
+                if (binding.isButton || binding.value != 1.0f || chordKeys.Test(binding.key))
+                {
+                    simple[action] = 0;
+                }
+                else
+                {
+                    simpleKeys[action].Set(binding.key);
+                }
+                chord = chord || (!binding.isButton && chordKeys.Test(binding.key));
+            }
+
+            if (chord)
+            {
+                chordActions.push_back(action);
+            }
+        }
+
+        values.assign(actionCount, 0.0f);
+        pressed.assign(actionCount, 0);
+        released.assign(actionCount, 0);
+        changed.clear();
+        // An action changes at most once per input event, so this never grows on the event path
+        changed.reserve(actionCount);
+        heldButtons = 0;
+        compiled = true;
+    }
+
+    bool ActionMap::IsBestMatch(const Binding &binding, uint16_t modifiers) const
+    {
+        if ((binding.modifiers & ~modifiers) != 0)
+        {
+            return false;
+        }
+
+        // Another binding on the same key that needs more of the held modifiers wins
+        int count = __builtin_popcount(binding.modifiers);
+        size_t key = static_cast<size_t>(binding.key);
+        for (uint32_t i = keyOffsets[key]; i < keyOffsets[key + 1]; i++)
+        {
+            uint16_t other = bindings[keyBindings[i]].modifiers;
+            if ((other & ~modifiers) == 0 && __builtin_popcount(other) > count)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    float ActionMap::Evaluate(ActionId action, const KeyboardState &keys, uint16_t modifiers) const
+    {
+        if (simple[action])
+        {
+            return keys.Intersects(simpleKeys[action]) ? 1.0f : 0.0f;
+        }
+
+        float value = 0.0f;
+        for (uint32_t i = actionOffsets[action]; i < actionOffsets[action + 1]; i++)
+        {
+            const Binding &binding = bindings[actionBindings[i]];
+            bool held = binding.isButton ? (heldButtons >> static_cast<int>(binding.button)) & 1
+                                         : keys.Test(binding.key) && IsBestMatch(binding, modifiers);
+            if (held)
+            {
+                value += binding.value;
+            }
+        }
+
+        return value < -1.0f ? -1.0f : value > 1.0f ? 1.0f : value;
+    }
+
+    void ActionMap::Update(ActionId action, const KeyboardState &keys, uint16_t modifiers)
+    {
+        float value = Evaluate(action, keys, modifiers);
+        if (value == values[action])
+        {
+            return;
+        }
+
+        bool wasDown = values[action] != 0.0f;
+        bool isDown = value != 0.0f;
+        if (!wasDown && isDown)
+        {
+            pressed[action] = 1;
+        }
+        else if (wasDown && !isDown)
+        {
+            released[action] = 1;
+        }
+
+        values[action] = value;
+        changed.push_back(action);
+    }
+
+    void ActionMap::Sync(const KeyboardState &keys)
+    {
+        uint16_t modifiers = HeldModifiers(keys);
+        for (ActionId action = 0; action < values.size(); action++)
+        {
+            values[action] = Evaluate(action, keys, modifiers);
+        }
+    }
+
+    void ActionMap::BeginFrame()
+    {
+        for (size_t i = 0; i < pressed.size(); i++)
+        {
+            pressed[i] = 0;
+            released[i] = 0;
+        }
+    }
+
+    void ActionMap::KeyChanged(Key key, const KeyboardState &keys)
+    {
+        uint16_t modifiers = HeldModifiers(keys);
+
+        size_t index = static_cast<size_t>(key);
+        for (uint32_t i = keyOffsets[index]; i < keyOffsets[index + 1]; i++)
+        {
+            Update(bindings[keyBindings[i]].action, keys, modifiers);
+        }
+
+        if (modifierKeys.Test(key))
+        {
+            for (ActionId action : chordActions)
+            {
+                Update(action, keys, modifiers);
+            }
+        }
+    }
+
+    void ActionMap::ButtonChanged(MouseButton button, bool down, const KeyboardState &keys)
+    {
+        uint32_t bit = uint32_t(1) << static_cast<int>(button);
+        heldButtons = down ? heldButtons | bit : heldButtons & ~bit;
+
+        uint16_t modifiers = HeldModifiers(keys);
+        for (uint32_t index : buttonBindings)
+        {
+            if (bindings[index].button == button)
+            {
+                Update(bindings[index].action, keys, modifiers);
+            }
+        }
+    }
+}
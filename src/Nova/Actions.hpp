@@ -0,0 +1,95 @@
+#pragma once
+#include <Nova/Event.hpp>
+#include <Nova/KeyboardState.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Nova
+{
+    /// @brief Maps keys, chords like Ctrl+Shift+S, mouse buttons and key axes to application actions.
+    /// Bindings are declared once, Window::SetActionMap compiles them into flat per key and per action
+    /// tables. An input event then only re-evaluates the actions bound to its key. Actions bound to
+    /// plain keys resolve with a single KeyboardState intersection.
+    class ActionMap
+    {
+    private:
+        class Binding
+        {
+        public:
+            ActionId action = 0;
+            Key key = Key::KEY_UNKNOWN;
+            MouseButton button = MouseButton::Left;
+            bool isButton = false;
+            uint16_t modifiers = 0;
+            float value = 1.0f;
+        };
+
+        std::vector<Binding> bindings;
+        bool compiled = false;
+
+        // Compiled tables: bindings of a key are keyBindings[keyOffsets[key]] up to keyOffsets[key + 1],
+        // the same layout is used per action
+        std::vector<uint32_t> keyOffsets;
+        std::vector<uint32_t> keyBindings;
+        std::vector<uint32_t> actionOffsets;
+        std::vector<uint32_t> actionBindings;
+        std::vector<uint32_t> buttonBindings;
+
+        // Actions whose bindings are all plain keys with value 1 on keys without chords, they are
+        // down exactly when the key state intersects their mask
+        std::vector<uint8_t> simple;
+        std::vector<KeyboardState> simpleKeys;
+
+        // Actions bound to a key that has a chord, re-evaluated whenever a modifier key changes
+        std::vector<ActionId> chordActions;
+
+        uint32_t heldButtons = 0;
+
+        std::vector<float> values;
+        std::vector<uint8_t> pressed;
+        std::vector<uint8_t> released;
+        std::vector<ActionId> changed;
+
+        bool IsBestMatch(const Binding &binding, uint16_t modifiers) const;
+        float Evaluate(ActionId action, const KeyboardState &keys, uint16_t modifiers) const;
+        void Update(ActionId action, const KeyboardState &keys, uint16_t modifiers);
+
+    public:
+        /// @brief Action is down while key is held together with at least modifiers (Modifier bits,
+        /// only Shift, Ctrl, Alt and Super count). If chords on the same key match, only the one with
+        /// the most modifiers does, so Ctrl+S does not also trigger S. value is what the key adds to
+        /// the action's value. Action ids index flat arrays, keep them small like an enum.
+        void BindKey(ActionId action, Key key, uint16_t modifiers = 0, float value = 1.0f);
+
+        /// @brief Action value is -1 while negative is held, 1 while positive is held and 0 for both
+        void BindAxis(ActionId action, Key negative, Key positive);
+
+        void BindMouseButton(ActionId action, MouseButton button, float value = 1.0f);
+
+        /// @brief Builds the lookup tables, done by Window::SetActionMap if not called before
+        void Compile();
+        bool IsCompiled() const { return compiled; }
+
+        /// @brief Re-evaluates every action against keys without reporting changes
+        void Sync(const KeyboardState &keys);
+
+        /// @brief Forgets which actions were pressed or released, called at the start of every poll
+        void BeginFrame();
+
+        /// @brief Re-evaluates the actions bound to key after keys changed, changes are collected in GetChanges
+        void KeyChanged(Key key, const KeyboardState &keys);
+        void ButtonChanged(MouseButton button, bool down, const KeyboardState &keys);
+
+        /// @brief Actions whose value changed since the last ClearChanges
+        const std::vector<ActionId> &GetChanges() const { return changed; }
+        void ClearChanges() { changed.clear(); }
+
+        size_t ActionCount() const { return values.size(); }
+
+        bool IsDown(ActionId action) const { return action < values.size() && values[action] != 0.0f; }
+        bool WasPressed(ActionId action) const { return action < pressed.size() && pressed[action]; }
+        bool WasReleased(ActionId action) const { return action < released.size() && released[action]; }
+        float GetValue(ActionId action) const { return action < values.size() ? values[action] : 0.0f; }
+    };
+}
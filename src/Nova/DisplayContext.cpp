@@ -0,0 +1,372 @@
+#include <Nova/DisplayContext.hpp>
+#include <Nova/Nova.hpp>
+#include <Flux/Flux.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace Nova
+{
+    void DisplayContext::WindowMap::Insert(X11Window window, X11Backend *backend)
+    {
+        // Kept at most half full, so probes stay short and Find always reaches a free slot
+        if ((count + 1) * 2 > slots.size())
+        {
+            Grow();
+        }
+
+        size_t i = Home(window);
+        while (slots[i].window != 0 && slots[i].window != window)
+        {
+            i = (i + 1) & (slots.size() - 1);
+        }
+
+        if (slots[i].window == 0)
+        {
+            count++;
+        }
+        slots[i].window = window;
+        slots[i].backend = backend;
+    }
+
+    void DisplayContext::WindowMap::Erase(X11Window window)
+    {
+        size_t mask = slots.size() - 1;
+        size_t i = Home(window);
+        while (slots[i].window != window)
+        {
+            if (slots[i].window == 0)
+            {
+                return;
+            }
+            i = (i + 1) & mask;
+        }
+
+        // Backward shift deletion: move later entries of the cluster into the hole unless that would
+        // put them before their home slot, so no tombstones are needed
+        size_t hole = i;
+        for (size_t j = (hole + 1) & mask; slots[j].window != 0; j = (j + 1) & mask)
+        {
+            size_t home = Home(slots[j].window);
+            if (((j - home) & mask) >= ((j - hole) & mask))
+            {
+                slots[hole] = slots[j];
+                hole = j;
+            }
+        }
+
+        slots[hole] = Slot();
+        count--;
+    }
+
+    void DisplayContext::WindowMap::Grow()
+    {
+        std::vector<Slot> old(slots.size() * 2);
+        old.swap(slots);
+        count = 0;
+
+        for (const Slot &slot : old)
+        {
+            if (slot.window != 0)
+            {
+                Insert(slot.window, slot.backend);
+            }
+        }
+    }
+
+    DisplayContext::DisplayContext()
+    {
+        display = XOpenDisplay(nullptr);
+        if (display == nullptr)
+        {
+            Flux::Error("Unable to open X display, windows on this context will not be created");
+            return;
+        }
+
+        if (!atoms.Load(display))
+        {
+            Flux::Error("Unable to intern X atoms");
+        }
+
+        wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (wakeFd == -1)
+        {
+            Flux::Error("Unable to create wake eventfd, PostEmptyEvent will not wake WaitEvents");
+        }
+    }
+
+    DisplayContext::~DisplayContext()
+    {
+        if (!backends.empty())
+        {
+            Flux::Error("DisplayContext destroyed before its {} windows", backends.size());
+        }
+
+        if (wakeFd != -1)
+        {
+            close(wakeFd);
+        }
+
+        if (display != nullptr)
+        {
+            XCloseDisplay(display);
+        }
+    }
+
+    void DisplayContext::Register(X11Backend *backend)
+    {
+        windows.Insert(backend->window, backend);
+        backends.push_back(backend);
+    }
+
+    void DisplayContext::Unregister(X11Backend *backend)
+    {
+        windows.Erase(backend->window);
+        if (lockOwner == backend)
+        {
+            lockOwner = nullptr;
+        }
+        backends.erase(std::remove(backends.begin(), backends.end(), backend), backends.end());
+    }
+
+    void DisplayContext::Pump()
+    {
+        if (display == nullptr)
+        {
+            return;
+        }
+
+        while (XPending(display) > 0)
+        {
+            XEvent event;
+            XNextEvent(display, &event);
+            Route(event, std::chrono::steady_clock::now());
+        }
+    }
+
+    void DisplayContext::Route(XEvent &event, std::chrono::steady_clock::time_point hostTime)
+    {
+        switch (event.type)
+        {
+        case MappingNotify:
+        {
+            // Not tied to a window, every window rebuilds its keycode table
+            for (X11Backend *backend : backends)
+            {
+                Deliver(backend, event, hostTime);
+            }
+            return;
+        }
+
+#ifdef NOVA_HAS_XINPUT2
+        case GenericEvent:
+        {
+            // The cookie is only valid until the next XNextEvent, so its data is claimed here and the
+            // receiving window frees it
+            if (backends.empty() || event.xcookie.extension != backends.front()->xiOpcode ||
+                !XGetEventData(display, &event.xcookie))
+            {
+                return;
+            }
+
+            X11Backend *receiver = nullptr;
+            switch (event.xcookie.evtype)
+            {
+            case XI_RawMotion:
+                // Selected on the root window, it belongs to the window that locked the cursor
+                receiver = lockOwner != nullptr && lockOwner->rawMotion ? lockOwner : nullptr;
+                break;
+
+            case XI_DeviceChanged:
+            {
+                // Device state, not tied to a window, every window keeps its own scroll valuators
+                XIDeviceChangedEvent *changed = static_cast<XIDeviceChangedEvent *>(event.xcookie.data);
+                for (X11Backend *backend : backends)
+                {
+                    backend->LoadScrollValuators(changed->sourceid, changed->classes, changed->num_classes);
+                }
+                break;
+            }
+
+            case XI_Enter:
+                receiver = windows.Find(static_cast<XIEnterEvent *>(event.xcookie.data)->event);
+                break;
+
+            case XI_Motion:
+            case XI_ButtonPress:
+            case XI_ButtonRelease:
+                receiver = windows.Find(static_cast<XIDeviceEvent *>(event.xcookie.data)->event);
+                break;
+
+            default:
+                break;
+            }
+
+            if (receiver != nullptr)
+            {
+                Deliver(receiver, event, hostTime);
+            }
+            else
+            {
+                XFreeEventData(display, &event.xcookie);
+            }
+            return;
+        }
+#endif
+
+        default:
+            break;
+        }
+
+        // XAnyEvent's window is the event window for window events, the drawable for ShmCompletion
+        // and the requestor or owner for selection events, always one of ours
+        X11Window target = event.xany.window;
+
+        X11Backend *backend = windows.Find(target);
+        if (backend != nullptr)
+        {
+            // Completions are consumed right away, a framebuffer waiting in XIfEvent would never see
+            // one that already sits in the window's queue
+            if (backend->framebuffer && backend->framebuffer->HandleEvent(event))
+            {
+                return;
+            }
+
+            Deliver(backend, event, hostTime);
+            return;
+        }
+
+        // Input method transports talk through windows Xlib created itself, XFilterEvent hands
+        // their messages to it. Everything else is for a window that was already destroyed.
+        XFilterEvent(&event, None);
+    }
+
+    void DisplayContext::Deliver(X11Backend *backend, XEvent &event, std::chrono::steady_clock::time_point hostTime)
+    {
+        X11RoutedEvent routed;
+        routed.event = event;
+        routed.hostTime = hostTime;
+
+        if (!backend->sharedEvents->Push(routed))
+        {
+            backend->owner.droppedEvents++;
+#ifdef NOVA_HAS_XINPUT2
+            if (event.type == GenericEvent && event.xcookie.data != nullptr)
+            {
+                XFreeEventData(display, &event.xcookie);
+            }
+#endif
+        }
+    }
+
+    bool DisplayContext::HasPendingInput()
+    {
+        if (display != nullptr && XPending(display) > 0)
+        {
+            return true;
+        }
+
+        for (X11Backend *backend : backends)
+        {
+            if (backend->owner.HasPendingInput())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void DisplayContext::WaitForInput(const struct timespec *timeout)
+    {
+        // One descriptor for the connection and the context's eventfd, then every window's eventfd
+        // and gamepad set. Negative descriptors are skipped by ppoll.
+        pollFds.clear();
+        pollFds.push_back({display != nullptr ? ConnectionNumber(display) : -1, POLLIN, 0});
+        pollFds.push_back({wakeFd, POLLIN, 0});
+        for (X11Backend *backend : backends)
+        {
+            Window &owner = backend->owner;
+            pollFds.push_back({owner.wakeFd, POLLIN, 0});
+            pollFds.push_back({owner.gamepads ? owner.gamepads->GetFd() : -1, POLLIN, 0});
+        }
+
+        if (ppoll(pollFds.data(), pollFds.size(), timeout, nullptr) < 0 && errno != EINTR)
+        {
+            Flux::Error("Waiting for events failed: {}", errno);
+            return;
+        }
+
+        // Drain every eventfd that woke us, gamepad sets are read by the windows' next poll
+        for (size_t i = 1; i < pollFds.size(); i++)
+        {
+            bool isWakeFd = i == 1 || i % 2 == 0;
+            if (isWakeFd && (pollFds[i].revents & POLLIN))
+            {
+                uint64_t value;
+                ssize_t result = read(pollFds[i].fd, &value, sizeof(value));
+                (void)result;
+            }
+        }
+    }
+
+    void DisplayContext::WaitEvents()
+    {
+        std::chrono::nanoseconds deadline = std::chrono::nanoseconds::max();
+        for (X11Backend *backend : backends)
+        {
+            deadline = std::min(deadline, backend->owner.PendingDeadline());
+        }
+
+        // Held back resizes and replayed events of any window have to be delivered on time
+        if (deadline != std::chrono::nanoseconds::max())
+        {
+            WaitEventsTimeout(deadline);
+            return;
+        }
+
+        if (!HasPendingInput())
+        {
+            WaitForInput(nullptr);
+        }
+
+        Pump();
+    }
+
+    void DisplayContext::WaitEventsTimeout(std::chrono::nanoseconds timeout)
+    {
+        if (!HasPendingInput())
+        {
+            for (X11Backend *backend : backends)
+            {
+                timeout = std::min(timeout, backend->owner.PendingDeadline());
+            }
+
+            if (timeout < std::chrono::nanoseconds::zero())
+            {
+                timeout = std::chrono::nanoseconds::zero();
+            }
+
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+
+            struct timespec ts;
+            ts.tv_sec = seconds.count();
+            ts.tv_nsec = (timeout - seconds).count();
+            WaitForInput(&ts);
+        }
+
+        Pump();
+    }
+
+    void DisplayContext::PostEmptyEvent()
+    {
+        if (wakeFd == -1)
+        {
+            return;
+        }
+
+        uint64_t value = 1;
+        ssize_t written = write(wakeFd, &value, sizeof(value));
+        (void)written;
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <Nova/X11.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <poll.h>
+
+namespace Nova
+{
+    /// @brief One X connection shared by any number of Windows. The context reads the connection for
+    /// all of them and hands each event to its window through a flat hash of X window IDs, so opening
+    /// another window costs no connection, no atom round trip and no extra descriptor to wait on.
+    /// Windows created on a context must be destroyed before it.
+    class DisplayContext
+    {
+    private:
+        friend class X11Backend;
+
+        // Open addressing with linear probing, X window IDs are never 0 so 0 marks a free slot
+        class WindowMap
+        {
+        private:
+            class Slot
+            {
+            public:
+                X11Window window = 0;
+                X11Backend *backend = nullptr;
+            };
+
+            std::vector<Slot> slots;
+            size_t count = 0;
+
+            size_t Home(X11Window window) const
+            {
+                // Fibonacci hashing, IDs of one client share their high bits and differ in the low ones
+                return static_cast<size_t>((static_cast<uint64_t>(window) * 0x9E3779B97F4A7C15ull) >> 32) & (slots.size() - 1);
+            }
+
+            void Grow();
+
+        public:
+            WindowMap() : slots(16) {}
+
+            void Insert(X11Window window, X11Backend *backend);
+            void Erase(X11Window window);
+
+            X11Backend *Find(X11Window window) const
+            {
+                for (size_t i = Home(window);; i = (i + 1) & (slots.size() - 1))
+                {
+                    if (slots[i].window == window)
+                    {
+                        return slots[i].backend;
+                    }
+                    if (slots[i].window == 0)
+                    {
+                        return nullptr;
+                    }
+                }
+            }
+        };
+
+        Display *display = nullptr;
+        X11Atoms atoms;
+
+        WindowMap windows;
+        // Every registered window in creation order, for broadcasts and for waiting on all of them
+        std::vector<X11Backend *> backends;
+
+        // Window that locked the cursor. The pointer grab and the raw motion selection on the root
+        // window belong to the connection, so locking another window unlocks this one first.
+        X11Backend *lockOwner = nullptr;
+
+        // eventfd written by PostEmptyEvent
+        int wakeFd = -1;
+        std::vector<struct pollfd> pollFds;
+
+        void Register(X11Backend *backend);
+        void Unregister(X11Backend *backend);
+
+        void Route(XEvent &event, std::chrono::steady_clock::time_point hostTime);
+        void Deliver(X11Backend *backend, XEvent &event, std::chrono::steady_clock::time_point hostTime);
+
+        bool HasPendingInput();
+        void WaitForInput(const struct timespec *timeout);
+
+    public:
+        /// @brief Opens the display named by DISPLAY. If that fails the error is logged and IsValid
+        /// returns false, windows created on the context then fall back like a Window without a server.
+        DisplayContext();
+        ~DisplayContext();
+
+        DisplayContext(const DisplayContext &) = delete;
+        DisplayContext &operator=(const DisplayContext &) = delete;
+
+        bool IsValid() const { return display != nullptr; }
+
+        Display *GetDisplay() const { return display; }
+
+        /// @brief Reads everything the server has sent and hands it to the windows it belongs to.
+        /// Window::PollEvents does this itself, so it is only needed to route without polling.
+        void Pump();
+
+        /// @brief Sleeps until any window of the context has input, a gamepad of one of them is ready
+        /// or PostEmptyEvent is called, then routes what arrived. Call PollEvents on every window
+        /// afterwards. Returns at once if a window already has something to deliver.
+        void WaitEvents();
+
+        /// @brief Like WaitEvents, but gives up waiting after timeout
+        void WaitEventsTimeout(std::chrono::nanoseconds timeout);
+
+        /// @brief Wakes a thread blocked in WaitEvents, safe to call from any thread. Window::PostEmptyEvent
+        /// on a window of the context wakes it as well.
+        void PostEmptyEvent();
+    };
+}
@@ -0,0 +1,290 @@
+#pragma once
+#include <Nova/Key.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <variant>
+
+namespace Nova
+{
+    enum class MouseButton
+    {
+        Left,
+        Right,
+        Middle,
+        /// @brief Side buttons, X11 buttons 8 and 9
+        Back,
+        Forward
+    };
+
+    /// @brief Bits of the modifiers mask carried by key and text events
+    enum class Modifier : uint16_t
+    {
+        Shift = 1 << 0,
+        CapsLock = 1 << 1,
+        Ctrl = 1 << 2,
+        Alt = 1 << 3,
+        NumLock = 1 << 4,
+        Super = 1 << 5
+    };
+
+    inline bool HasModifier(uint16_t modifiers, Modifier modifier)
+    {
+        return (modifiers & static_cast<uint16_t>(modifier)) != 0;
+    }
+
+    /// @brief Decodes a core X modifier mask (xkey.state). Wayland compositors send the same bit
+    /// layout for the default xkb keymap: Shift, Lock, Control, Mod1 (Alt), Mod2 (NumLock), Mod4 (Super).
+    inline uint16_t ModifiersFromCoreMask(uint32_t mask)
+    {
+        uint16_t modifiers = 0;
+        modifiers |= (mask & (1 << 0)) ? static_cast<uint16_t>(Modifier::Shift) : 0;
+        modifiers |= (mask & (1 << 1)) ? static_cast<uint16_t>(Modifier::CapsLock) : 0;
+        modifiers |= (mask & (1 << 2)) ? static_cast<uint16_t>(Modifier::Ctrl) : 0;
+        modifiers |= (mask & (1 << 3)) ? static_cast<uint16_t>(Modifier::Alt) : 0;
+        modifiers |= (mask & (1 << 4)) ? static_cast<uint16_t>(Modifier::NumLock) : 0;
+        modifiers |= (mask & (1 << 6)) ? static_cast<uint16_t>(Modifier::Super) : 0;
+        return modifiers;
+    }
+
+    /// @brief Fields shared by every event
+    class EventBase
+    {
+    public:
+        /// @brief Timestamp from the display server in milliseconds (xkey.time, xbutton.time, xmotion.time)
+        uint32_t serverTime = 0;
+        /// @brief Monotonic host time at which Nova read the event from the display connection
+        std::chrono::steady_clock::time_point hostTime;
+    };
+
+    class MouseMoveEvent : public EventBase
+    {
+    public:
+        /// @brief Pointer position, or the integer motion delta when relative is set
+        int x = 0;
+        int y = 0;
+
+        /// @brief Set while the cursor is locked, x/y and deltaX/deltaY are then relative motion
+        bool relative = false;
+        /// @brief Unrounded relative motion (sub-pixel and unaccelerated when XInput2 raw motion is used)
+        double deltaX = 0.0;
+        double deltaY = 0.0;
+
+        /// @brief Number of raw motion samples merged into this event by motion coalescing
+        int samples = 1;
+    };
+
+    class MouseButtonDownEvent : public EventBase
+    {
+    public:
+        MouseButton button = MouseButton::Left;
+    };
+
+    class MouseButtonUpEvent : public EventBase
+    {
+    public:
+        MouseButton button = MouseButton::Left;
+    };
+
+    class KeyDownEvent : public EventBase
+    {
+    public:
+        Key key;
+        bool shift = false;
+        /// @brief Modifiers held just before the press, not including the pressed key
+        uint16_t modifiers = 0;
+    };
+
+    class KeyUpEvent : public EventBase
+    {
+    public:
+        Key key;
+        bool shift = false;
+        /// @brief Modifiers held just before the release, including the released key
+        uint16_t modifiers = 0;
+    };
+
+    /// @brief Sent instead of another KeyDownEvent while a held key auto-repeats
+    class KeyRepeatEvent : public EventBase
+    {
+    public:
+        Key key;
+        bool shift = false;
+        uint16_t modifiers = 0;
+        /// @brief 1 for the first repeat after the press, counting up while the key stays down
+        int repeatCount = 1;
+    };
+
+    /// @brief New client area size, sent once per poll with the final size of a resize
+    class WindowResizeEvent : public EventBase
+    {
+    public:
+        int width = 0;
+        int height = 0;
+    };
+
+    /// @brief Text the user typed, after the keyboard layout, dead keys, compose and the input method.
+    /// Independent of key events, a key press can produce no text or text for several events.
+    class TextInputEvent : public EventBase
+    {
+    public:
+        static constexpr size_t Capacity = 15;
+
+        /// @brief UTF-8, null terminated and never split inside a code point. Longer input arrives
+        /// as several events.
+        char text[Capacity + 1] = {};
+        uint8_t length = 0;
+        uint16_t modifiers = 0;
+    };
+
+    /// @brief Gamepad buttons in the evdev gamepad layout, named by position
+    enum class GamepadButton
+    {
+        South,
+        East,
+        West,
+        North,
+        LeftShoulder,
+        RightShoulder,
+        LeftTrigger,
+        RightTrigger,
+        Back,
+        Start,
+        Guide,
+        LeftStick,
+        RightStick,
+        DPadUp,
+        DPadDown,
+        DPadLeft,
+        DPadRight,
+        /// @brief Any other button, e.g. of a joystick, code holds the evdev code
+        Other
+    };
+
+    enum class GamepadAxis
+    {
+        LeftX,
+        LeftY,
+        RightX,
+        RightY,
+        LeftTrigger,
+        RightTrigger,
+        /// @brief Any other absolute axis, code holds the evdev code
+        Other
+    };
+
+    class GamepadConnectedEvent : public EventBase
+    {
+    public:
+        /// @brief Slot of the pad, stays the same until it is disconnected
+        int gamepad = 0;
+    };
+
+    class GamepadDisconnectedEvent : public EventBase
+    {
+    public:
+        int gamepad = 0;
+    };
+
+    class GamepadButtonDownEvent : public EventBase
+    {
+    public:
+        int gamepad = 0;
+        GamepadButton button = GamepadButton::Other;
+        uint16_t code = 0;
+    };
+
+    class GamepadButtonUpEvent : public EventBase
+    {
+    public:
+        int gamepad = 0;
+        GamepadButton button = GamepadButton::Other;
+        uint16_t code = 0;
+    };
+
+    /// @brief Latest value of an axis after the deadzone, at most one per axis and poll
+    class GamepadAxisEvent : public EventBase
+    {
+    public:
+        int gamepad = 0;
+        GamepadAxis axis = GamepadAxis::Other;
+        uint16_t code = 0;
+        /// @brief -1 to 1 for sticks, Y pointing down, and 0 to 1 for triggers
+        float value = 0.0f;
+    };
+
+    /// @brief Application defined action, see ActionMap
+    using ActionId = uint32_t;
+
+    /// @brief An action of the window's ActionMap changed, queued right after the input event that changed it
+    class ActionEvent : public EventBase
+    {
+    public:
+        ActionId action = 0;
+        bool down = false;
+        /// @brief Sum of the values of the held bindings clamped to -1..1, 0 when the action is up
+        float value = 0.0f;
+    };
+
+    /// @brief Wheel or touchpad scrolling in wheel detents. Positive deltaY scrolls up (away from the
+    /// user), positive deltaX scrolls right.
+    class MouseScrollEvent : public EventBase
+    {
+    public:
+        double deltaX = 0.0;
+        double deltaY = 0.0;
+
+        /// @brief Set when the deltas come from XInput2 scroll valuators or a Wayland axis and can be
+        /// fractional, clear for whole wheel clicks
+        bool precise = false;
+
+        /// @brief Number of scroll steps accumulated into this event, see Window::SetScrollAccumulation
+        int samples = 1;
+    };
+
+    /// @brief Value type holding any Nova event, inspect with std::get_if or std::visit
+    using Event = std::variant<MouseMoveEvent, MouseButtonDownEvent, MouseButtonUpEvent, KeyDownEvent, KeyUpEvent, KeyRepeatEvent,
+                               WindowResizeEvent, TextInputEvent, ActionEvent, GamepadConnectedEvent, GamepadDisconnectedEvent,
+                               GamepadButtonDownEvent, GamepadButtonUpEvent, GamepadAxisEvent, MouseScrollEvent>;
+
+    enum class MotionCoalescing
+    {
+        /// @brief Every motion sample becomes its own MouseMoveEvent
+        Disabled,
+        /// @brief Consecutive motion within one PollEvents call becomes a single event
+        PerPoll,
+        /// @brief Consecutive motion is merged into one event per time bucket
+        Bucket
+    };
+
+    /// @brief A single uncoalesced motion sample, position or relative delta depending on relative
+    class MotionSample
+    {
+    public:
+        double x = 0.0;
+        double y = 0.0;
+        bool relative = false;
+        uint32_t serverTime = 0;
+    };
+
+    /// @brief Position of T in the Event variant, what event.index() returns for a T
+    template <typename T, size_t Index = 0>
+    constexpr size_t EventIndex()
+    {
+        if constexpr (std::is_same_v<std::variant_alternative_t<Index, Event>, T>)
+        {
+            return Index;
+        }
+        else
+        {
+            return EventIndex<T, Index + 1>();
+        }
+    }
+
+    /// @brief Access the timestamps of any event without knowing its type
+    inline const EventBase &GetEventBase(const Event &event)
+    {
+        return std::visit([](const auto &value) -> const EventBase & { return value; }, event);
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace Nova
+{
+    inline size_t RoundUpToPowerOfTwo(size_t value)
+    {
+        size_t result = 1;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    /// @brief Fixed capacity FIFO ring buffer. Storage is allocated once on construction and reused,
+    /// so pushing and popping never touches the heap.
+    template <typename T>
+    class RingBuffer
+    {
+    private:
+        std::vector<T> storage;
+        size_t mask;
+        size_t head = 0;
+        size_t count = 0;
+
+    public:
+        explicit RingBuffer(size_t capacity)
+            : storage(RoundUpToPowerOfTwo(capacity)), mask(storage.size() - 1)
+        {
+        }
+
+        /// @brief Appends a value, returns false (and drops the value) if the buffer is full
+        bool Push(const T &value)
+        {
+            if (count == storage.size())
+            {
+                return false;
+            }
+
+            storage[(head + count) & mask] = value;
+            count++;
+            return true;
+        }
+
+        /// @brief Copies out the oldest value, returns false if the buffer is empty
+        bool Pop(T &out)
+        {
+            if (count == 0)
+            {
+                return false;
+            }
+
+            out = storage[head];
+            head = (head + 1) & mask;
+            count--;
+            return true;
+        }
+
+        T &Front() { return storage[head]; }
+        T &Back() { return storage[(head + count - 1) & mask]; }
+
+        bool Empty() const { return count == 0; }
+        bool Full() const { return count == storage.size(); }
+        size_t Size() const { return count; }
+        size_t Capacity() const { return storage.size(); }
+
+        void Clear()
+        {
+            head = 0;
+            count = 0;
+        }
+    };
+
+    /// @brief Lock-free single producer, single consumer ring buffer. Push may only be called from
+    /// one thread and Pop from one other thread. Storage is allocated once on construction.
+    template <typename T>
+    class SpscRing
+    {
+    private:
+        std::vector<T> storage;
+        size_t mask;
+
+        // Kept on separate cache lines so producer and consumer don't false share
+        alignas(64) std::atomic<size_t> head{0};
+        alignas(64) std::atomic<size_t> tail{0};
+
+    public:
+        explicit SpscRing(size_t capacity)
+            : storage(RoundUpToPowerOfTwo(capacity)), mask(storage.size() - 1)
+        {
+        }
+
+        /// @brief Producer side, returns false (and drops the value) if the ring is full
+        bool Push(const T &value)
+        {
+            size_t currentTail = tail.load(std::memory_order_relaxed);
+            if (currentTail - head.load(std::memory_order_acquire) == storage.size())
+            {
+                return false;
+            }
+
+            storage[currentTail & mask] = value;
+            tail.store(currentTail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// @brief Consumer side, returns false if the ring is empty
+        bool Pop(T &out)
+        {
+            size_t currentHead = head.load(std::memory_order_relaxed);
+            if (currentHead == tail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            out = storage[currentHead & mask];
+            head.store(currentHead + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool Empty() const
+        {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+    };
+}
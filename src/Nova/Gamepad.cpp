@@ -0,0 +1,707 @@
+#include <Nova/Nova.hpp>
+#include <Nova/Gamepad.hpp>
+#include <Flux/Flux.hpp>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+// Included last, its KEY_* macros collide with Nova::Key and nothing below names a Key
+#include <linux/input.h>
+
+namespace Nova
+{
+    // epoll data of the inotify watch, devices use their slot
+    static constexpr uint32_t InotifyToken = GamepadManager::MaxGamepads;
+
+    // Records read from a regular file per poll, so a recording plays back over several frames
+    // instead of overflowing the event queue at once
+    static constexpr size_t ReadBatch = 64;
+
+    static bool TestBit(const unsigned long *bits, int bit)
+    {
+        constexpr int bitsPerWord = 8 * sizeof(unsigned long);
+        return (bits[bit / bitsPerWord] >> (bit % bitsPerWord)) & 1;
+    }
+
+    static void SetBit(unsigned long *bits, int bit, bool value)
+    {
+        constexpr int bitsPerWord = 8 * sizeof(unsigned long);
+        unsigned long mask = 1UL << (bit % bitsPerWord);
+        bits[bit / bitsPerWord] = value ? bits[bit / bitsPerWord] | mask : bits[bit / bitsPerWord] & ~mask;
+    }
+
+    static bool IsTrigger(int code)
+    {
+        return code == ABS_Z || code == ABS_RZ || code == ABS_GAS || code == ABS_BRAKE;
+    }
+
+    static bool IsHat(int code)
+    {
+        return code >= ABS_HAT0X && code <= ABS_HAT3Y;
+    }
+
+    static GamepadButton EvdevButton(uint16_t code)
+    {
+        switch (code)
+        {
+        case BTN_SOUTH:
+            return GamepadButton::South;
+        case BTN_EAST:
+            return GamepadButton::East;
+        case BTN_WEST:
+            return GamepadButton::West;
+        case BTN_NORTH:
+            return GamepadButton::North;
+        case BTN_TL:
+            return GamepadButton::LeftShoulder;
+        case BTN_TR:
+            return GamepadButton::RightShoulder;
+        case BTN_TL2:
+            return GamepadButton::LeftTrigger;
+        case BTN_TR2:
+            return GamepadButton::RightTrigger;
+        case BTN_SELECT:
+            return GamepadButton::Back;
+        case BTN_START:
+            return GamepadButton::Start;
+        case BTN_MODE:
+            return GamepadButton::Guide;
+        case BTN_THUMBL:
+            return GamepadButton::LeftStick;
+        case BTN_THUMBR:
+            return GamepadButton::RightStick;
+        case BTN_DPAD_UP:
+            return GamepadButton::DPadUp;
+        case BTN_DPAD_DOWN:
+            return GamepadButton::DPadDown;
+        case BTN_DPAD_LEFT:
+            return GamepadButton::DPadLeft;
+        case BTN_DPAD_RIGHT:
+            return GamepadButton::DPadRight;
+        default:
+            return GamepadButton::Other;
+        }
+    }
+
+    static GamepadAxis EvdevAxis(uint16_t code)
+    {
+        switch (code)
+        {
+        case ABS_X:
+            return GamepadAxis::LeftX;
+        case ABS_Y:
+            return GamepadAxis::LeftY;
+        case ABS_RX:
+            return GamepadAxis::RightX;
+        case ABS_RY:
+            return GamepadAxis::RightY;
+        case ABS_Z:
+        case ABS_BRAKE:
+            return GamepadAxis::LeftTrigger;
+        case ABS_RZ:
+        case ABS_GAS:
+            return GamepadAxis::RightTrigger;
+        default:
+            return GamepadAxis::Other;
+        }
+    }
+
+    GamepadManager::GamepadManager(Window &owner)
+        : owner(owner)
+    {
+    }
+
+    GamepadManager::~GamepadManager()
+    {
+        for (Device &device : devices)
+        {
+            if (device.fd != -1)
+            {
+                close(device.fd);
+            }
+        }
+
+        if (inotifyFd != -1)
+        {
+            close(inotifyFd);
+        }
+        if (epollFd != -1)
+        {
+            close(epollFd);
+        }
+    }
+
+    bool GamepadManager::Create()
+    {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd == -1)
+        {
+            Flux::Error("Unable to create gamepad epoll set: {}", errno);
+            return false;
+        }
+        return true;
+    }
+
+    bool GamepadManager::Watch(const std::string &path)
+    {
+        if (inotifyFd != -1)
+        {
+            return path == directory;
+        }
+
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd == -1)
+        {
+            Flux::Error("Unable to create inotify instance: {}", errno);
+            return false;
+        }
+
+        // udev creates the node before it sets the permissions, so a failed open is retried on IN_ATTRIB
+        if (inotify_add_watch(inotifyFd, path.c_str(), IN_CREATE | IN_ATTRIB | IN_DELETE | IN_MOVED_TO) == -1)
+        {
+            Flux::Error("Unable to watch {} for gamepads: {}", path, errno);
+            close(inotifyFd);
+            inotifyFd = -1;
+            return false;
+        }
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u32 = InotifyToken;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, inotifyFd, &event);
+
+        directory = path;
+        ScanDirectory();
+        return true;
+    }
+
+    void GamepadManager::ScanDirectory()
+    {
+        DIR *dir = opendir(directory.c_str());
+        if (dir == nullptr)
+        {
+            Flux::Error("Unable to open {}: {}", directory, errno);
+            return;
+        }
+
+        while (dirent *entry = readdir(dir))
+        {
+            if (strncmp(entry->d_name, "event", 5) == 0)
+            {
+                OpenDevice(directory + "/" + entry->d_name, true);
+            }
+        }
+
+        closedir(dir);
+    }
+
+    void GamepadManager::ReadInotify()
+    {
+        alignas(inotify_event) char buffer[4096];
+
+        for (;;)
+        {
+            ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0)
+            {
+                return;
+            }
+
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const inotify_event *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                if (event->len == 0 || strncmp(event->name, "event", 5) != 0)
+                {
+                    continue;
+                }
+
+                std::string path = directory + "/" + event->name;
+                if (event->mask & IN_DELETE)
+                {
+                    for (int slot = 0; slot < MaxGamepads; slot++)
+                    {
+                        if (devices[slot].fd != -1 && devices[slot].path == path)
+                        {
+                            CloseDevice(slot);
+                        }
+                    }
+                }
+                else
+                {
+                    OpenDevice(path, true);
+                }
+            }
+        }
+    }
+
+    int GamepadManager::Open(const std::string &path)
+    {
+        return OpenDevice(path, false);
+    }
+
+    int GamepadManager::OpenDevice(const std::string &path, bool requireGamepad)
+    {
+        int slot = -1;
+        for (int i = 0; i < MaxGamepads; i++)
+        {
+            if (devices[i].fd != -1 && devices[i].path == path)
+            {
+                return i;
+            }
+            if (devices[i].fd == -1 && slot == -1)
+            {
+                slot = i;
+            }
+        }
+
+        int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd == -1)
+        {
+            // Scanning meets plenty of nodes the user can't read, only explicit opens are errors
+            if (!requireGamepad)
+            {
+                Flux::Error("Unable to open gamepad {}: {}", path, errno);
+            }
+            return -1;
+        }
+
+        unsigned long keyBits[KeyWords] = {};
+        bool isDevice = ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keyBits)), keyBits) >= 0;
+
+        if (requireGamepad && (!isDevice || !(TestBit(keyBits, BTN_GAMEPAD) || TestBit(keyBits, BTN_JOYSTICK))))
+        {
+            close(fd);
+            return -1;
+        }
+
+        if (slot == -1)
+        {
+            Flux::Error("More than {} gamepads, ignoring {}", MaxGamepads, path);
+            close(fd);
+            return -1;
+        }
+
+        Device &device = devices[slot];
+        device = Device();
+        device.fd = fd;
+        device.path = path;
+        device.isDevice = isDevice;
+
+        if (!isDevice || ioctl(fd, EVIOCGNAME(sizeof(device.name)), device.name) < 0)
+        {
+            strncpy(device.name, path.c_str(), sizeof(device.name) - 1);
+        }
+
+        if (isDevice)
+        {
+            // Same clock as the display servers, so serverTime and the delivery latency compare
+            int clock = CLOCK_MONOTONIC;
+            ioctl(fd, EVIOCSCLOCKID, &clock);
+            ioctl(fd, EVIOCGKEY(sizeof(device.keyBits)), device.keyBits);
+        }
+
+        for (int code = 0; code < AxisCount; code++)
+        {
+            input_absinfo info = {};
+            if (isDevice && ioctl(fd, EVIOCGABS(code), &info) >= 0 && info.maximum > info.minimum)
+            {
+                device.axisMin[code] = info.minimum;
+                device.axisMax[code] = info.maximum;
+                device.axisRaw[code] = info.value;
+            }
+            else
+            {
+                // Recorded streams carry no ranges, assume the common ones
+                device.axisMin[code] = IsHat(code) ? -1 : IsTrigger(code) ? 0 : -32768;
+                device.axisMax[code] = IsHat(code) ? 1 : IsTrigger(code) ? 255 : 32767;
+                device.axisRaw[code] = IsTrigger(code) ? 0 : (device.axisMin[code] + device.axisMax[code]) / 2;
+            }
+            device.axisValue[code] = Normalize(device, code);
+        }
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u32 = static_cast<uint32_t>(slot);
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1)
+        {
+            if (errno != EPERM)
+            {
+                Flux::Error("Unable to add gamepad {} to the epoll set: {}", path, errno);
+                close(fd);
+                device = Device();
+                return -1;
+            }
+            device.alwaysReady = true;
+        }
+
+        Flux::Info("Gamepad {} connected: {}", slot, device.name);
+
+        if (!polling)
+        {
+            pendingConnections |= 1u << slot;
+            return slot;
+        }
+
+        GamepadConnectedEvent connected;
+        connected.gamepad = slot;
+        connected.hostTime = std::chrono::steady_clock::now();
+        owner.DispatchEvent(connected);
+        return slot;
+    }
+
+    void GamepadManager::CloseDevice(int slot)
+    {
+        Device &device = devices[slot];
+        if (!device.alwaysReady)
+        {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, device.fd, nullptr);
+        }
+        close(device.fd);
+
+        Flux::Info("Gamepad {} disconnected: {}", slot, device.name);
+        device = Device();
+        pendingConnections &= ~(1u << slot);
+
+        GamepadDisconnectedEvent disconnected;
+        disconnected.gamepad = slot;
+        disconnected.hostTime = std::chrono::steady_clock::now();
+        owner.DispatchEvent(disconnected);
+    }
+
+    void GamepadManager::CloseAll()
+    {
+        for (int slot = 0; slot < MaxGamepads; slot++)
+        {
+            if (devices[slot].fd != -1)
+            {
+                CloseDevice(slot);
+            }
+        }
+    }
+
+    void GamepadManager::PollEvents()
+    {
+        if (epollFd == -1)
+        {
+            return;
+        }
+
+        polling = true;
+
+        auto hostTime = std::chrono::steady_clock::now();
+        while (pendingConnections != 0)
+        {
+            int slot = __builtin_ctz(pendingConnections);
+            pendingConnections &= pendingConnections - 1;
+
+            GamepadConnectedEvent connected;
+            connected.gamepad = slot;
+            connected.hostTime = hostTime;
+            owner.DispatchEvent(connected);
+        }
+
+        epoll_event ready[MaxGamepads + 1];
+        int count = epoll_wait(epollFd, ready, MaxGamepads + 1, 0);
+        for (int i = 0; i < count; i++)
+        {
+            if (ready[i].data.u32 == InotifyToken)
+            {
+                ReadInotify();
+            }
+            else if (devices[ready[i].data.u32].fd != -1)
+            {
+                ReadDevice(static_cast<int>(ready[i].data.u32));
+            }
+        }
+
+        for (int slot = 0; slot < MaxGamepads; slot++)
+        {
+            if (devices[slot].fd != -1 && devices[slot].alwaysReady)
+            {
+                ReadDevice(slot);
+            }
+        }
+
+        polling = false;
+    }
+
+    bool GamepadManager::HasPendingInput()
+    {
+        if (pendingConnections != 0)
+        {
+            return true;
+        }
+
+        // Regular files are always readable, counting them would keep WaitEvents spinning until
+        // their end. They are paced by the polls that other input wakes instead.
+        epoll_event ready;
+        return epollFd != -1 && epoll_wait(epollFd, &ready, 1, 0) > 0;
+    }
+
+    void GamepadManager::ReadDevice(int slot)
+    {
+        Device &device = devices[slot];
+        input_event records[ReadBatch];
+        auto hostTime = std::chrono::steady_clock::now();
+        uint32_t serverTime = 0;
+
+        for (;;)
+        {
+            ssize_t length = read(device.fd, records, sizeof(records));
+            if (length < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (length < 0 && errno == EAGAIN)
+            {
+                break;
+            }
+            if (length <= 0)
+            {
+                // ENODEV once a pad is unplugged, end of file for a recorded stream or closed FIFO
+                FlushAxes(slot, serverTime, hostTime);
+                CloseDevice(slot);
+                return;
+            }
+
+            size_t count = static_cast<size_t>(length) / sizeof(input_event);
+            for (size_t i = 0; i < count; i++)
+            {
+                const input_event &record = records[i];
+                if (device.isDevice)
+                {
+                    serverTime = static_cast<uint32_t>(static_cast<uint64_t>(record.input_event_sec) * 1000 +
+                                                       static_cast<uint64_t>(record.input_event_usec) / 1000);
+                }
+                HandleInput(slot, record.type, record.code, record.value, serverTime, hostTime);
+            }
+
+            if (device.alwaysReady)
+            {
+                break;
+            }
+        }
+
+        FlushAxes(slot, serverTime, hostTime);
+    }
+
+    void GamepadManager::HandleInput(int slot, uint16_t type, uint16_t code, int32_t value, uint32_t serverTime,
+                                     std::chrono::steady_clock::time_point hostTime)
+    {
+        Device &device = devices[slot];
+
+        if (device.dropping)
+        {
+            if (type == EV_SYN && code == SYN_REPORT)
+            {
+                device.dropping = false;
+                Resync(slot, hostTime);
+            }
+            return;
+        }
+
+        switch (type)
+        {
+        case EV_SYN:
+            if (code == SYN_DROPPED)
+            {
+                // The kernel buffer overflowed, everything up to the next report is incomplete
+                device.dropping = true;
+            }
+            break;
+
+        case EV_KEY:
+            // 2 is autorepeat, which gamepads don't need
+            if (code < KeyCodeCount && value != 2 && TestBit(device.keyBits, code) != (value != 0))
+            {
+                SetBit(device.keyBits, code, value != 0);
+                EmitButton(slot, code, EvdevButton(code), value != 0, serverTime, hostTime);
+            }
+            break;
+
+        case EV_ABS:
+            if (code >= AxisCount)
+            {
+                break;
+            }
+
+            if (IsHat(code))
+            {
+                EmitHat(slot, code, value, serverTime, hostTime);
+            }
+            else
+            {
+                // Only the last value of a poll is delivered
+                device.axisRaw[code] = value;
+                device.dirtyAxes |= uint64_t(1) << code;
+            }
+            break;
+        }
+    }
+
+    void GamepadManager::EmitButton(int slot, uint16_t code, GamepadButton button, bool down, uint32_t serverTime,
+                                    std::chrono::steady_clock::time_point hostTime)
+    {
+        if (down)
+        {
+            GamepadButtonDownEvent buttonEvent;
+            buttonEvent.gamepad = slot;
+            buttonEvent.button = button;
+            buttonEvent.code = code;
+            buttonEvent.serverTime = serverTime;
+            buttonEvent.hostTime = hostTime;
+            owner.DispatchEvent(buttonEvent);
+        }
+        else
+        {
+            GamepadButtonUpEvent buttonEvent;
+            buttonEvent.gamepad = slot;
+            buttonEvent.button = button;
+            buttonEvent.code = code;
+            buttonEvent.serverTime = serverTime;
+            buttonEvent.hostTime = hostTime;
+            owner.DispatchEvent(buttonEvent);
+        }
+    }
+
+    void GamepadManager::EmitHat(int slot, uint16_t code, int32_t value, uint32_t serverTime,
+                                 std::chrono::steady_clock::time_point hostTime)
+    {
+        Device &device = devices[slot];
+        int previous = device.axisRaw[code];
+        device.axisRaw[code] = value;
+
+        // The first hat is the d-pad, the others only exist on joysticks and keep their code
+        bool vertical = (code - ABS_HAT0X) % 2 == 1;
+        bool dpad = code == ABS_HAT0X || code == ABS_HAT0Y;
+        GamepadButton negative = !dpad ? GamepadButton::Other : vertical ? GamepadButton::DPadUp : GamepadButton::DPadLeft;
+        GamepadButton positive = !dpad ? GamepadButton::Other : vertical ? GamepadButton::DPadDown : GamepadButton::DPadRight;
+
+        if (previous < 0 && value >= 0)
+        {
+            EmitButton(slot, code, negative, false, serverTime, hostTime);
+        }
+        if (previous > 0 && value <= 0)
+        {
+            EmitButton(slot, code, positive, false, serverTime, hostTime);
+        }
+        if (value < 0 && previous >= 0)
+        {
+            EmitButton(slot, code, negative, true, serverTime, hostTime);
+        }
+        if (value > 0 && previous <= 0)
+        {
+            EmitButton(slot, code, positive, true, serverTime, hostTime);
+        }
+    }
+
+    float GamepadManager::Normalize(const Device &device, int code) const
+    {
+        float range = static_cast<float>(device.axisMax[code]) - static_cast<float>(device.axisMin[code]);
+        if (range <= 0.0f)
+        {
+            return 0.0f;
+        }
+
+        float position = (static_cast<float>(device.axisRaw[code]) - static_cast<float>(device.axisMin[code])) / range;
+        float value = IsTrigger(code) ? position : position * 2.0f - 1.0f;
+        value = value < -1.0f ? -1.0f : value > 1.0f ? 1.0f : value;
+
+        // Rescaled so the output still starts at 0 and reaches 1 at the edge of the deadzone
+        float magnitude = std::fabs(value);
+        if (magnitude <= deadzone)
+        {
+            return 0.0f;
+        }
+        return std::copysign((magnitude - deadzone) / (1.0f - deadzone), value);
+    }
+
+    void GamepadManager::FlushAxes(int slot, uint32_t serverTime, std::chrono::steady_clock::time_point hostTime)
+    {
+        Device &device = devices[slot];
+
+        while (device.dirtyAxes != 0)
+        {
+            int code = __builtin_ctzll(device.dirtyAxes);
+            device.dirtyAxes &= device.dirtyAxes - 1;
+
+            float value = Normalize(device, code);
+            if (value == device.axisValue[code])
+            {
+                // Jitter inside the deadzone
+                continue;
+            }
+            device.axisValue[code] = value;
+
+            GamepadAxisEvent axisEvent;
+            axisEvent.gamepad = slot;
+            axisEvent.axis = EvdevAxis(static_cast<uint16_t>(code));
+            axisEvent.code = static_cast<uint16_t>(code);
+            axisEvent.value = value;
+            axisEvent.serverTime = serverTime;
+            axisEvent.hostTime = hostTime;
+            owner.DispatchEvent(axisEvent);
+        }
+    }
+
+    void GamepadManager::Resync(int slot, std::chrono::steady_clock::time_point hostTime)
+    {
+        Device &device = devices[slot];
+        if (!device.isDevice)
+        {
+            return;
+        }
+
+        unsigned long keyBits[KeyWords] = {};
+        if (ioctl(device.fd, EVIOCGKEY(sizeof(keyBits)), keyBits) >= 0)
+        {
+            for (int code = BTN_MISC; code < KeyCodeCount; code++)
+            {
+                bool down = TestBit(keyBits, code);
+                if (TestBit(device.keyBits, code) != down)
+                {
+                    SetBit(device.keyBits, code, down);
+                    EmitButton(slot, static_cast<uint16_t>(code), EvdevButton(static_cast<uint16_t>(code)), down, 0, hostTime);
+                }
+            }
+        }
+
+        for (int code = 0; code < AxisCount; code++)
+        {
+            input_absinfo info = {};
+            if (device.axisMax[code] <= device.axisMin[code] || ioctl(device.fd, EVIOCGABS(code), &info) < 0)
+            {
+                continue;
+            }
+
+            if (IsHat(code))
+            {
+                EmitHat(slot, static_cast<uint16_t>(code), info.value, 0, hostTime);
+            }
+            else if (info.value != device.axisRaw[code])
+            {
+                device.axisRaw[code] = info.value;
+                device.dirtyAxes |= uint64_t(1) << code;
+            }
+        }
+    }
+
+    bool GamepadManager::IsConnected(int gamepad) const
+    {
+        return gamepad >= 0 && gamepad < MaxGamepads && devices[gamepad].fd != -1;
+    }
+
+    const char *GamepadManager::GetName(int gamepad) const
+    {
+        return IsConnected(gamepad) ? devices[gamepad].name : "";
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <Nova/Event.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace Nova
+{
+    class Window;
+
+    /// @brief Gamepads and joysticks read straight from Linux evdev nodes. The devices and an inotify
+    /// watch on the device directory share one epoll set, and its descriptor joins the backend's
+    /// poll set, so WaitEvents wakes for a controller just like for the display connection.
+    class GamepadManager
+    {
+    public:
+        static constexpr int MaxGamepads = 8;
+        static constexpr float MaxDeadzone = 0.99f;
+
+    private:
+        // ABS_CNT and KEY_CNT from linux/input-event-codes.h
+        static constexpr int AxisCount = 0x40;
+        static constexpr int KeyCodeCount = 0x300;
+        static constexpr int KeyWords = KeyCodeCount / (8 * sizeof(unsigned long));
+
+        class Device
+        {
+        public:
+            int fd = -1;
+            std::string path;
+            char name[128] = {};
+
+            // An evdev node, as opposed to a recorded stream or FIFO opened with Open. Only devices
+            // have capabilities and CLOCK_MONOTONIC timestamps.
+            bool isDevice = false;
+            // Regular files can't be added to epoll, they are read a little on every poll instead
+            // and never wake WaitEvents
+            bool alwaysReady = false;
+            // Set by SYN_DROPPED, the state is read back from the device at the next SYN_REPORT
+            bool dropping = false;
+
+            int axisMin[AxisCount] = {};
+            int axisMax[AxisCount] = {};
+            int axisRaw[AxisCount] = {};
+            float axisValue[AxisCount] = {};
+            uint64_t dirtyAxes = 0;
+
+            unsigned long keyBits[KeyWords] = {};
+        };
+
+        Window &owner;
+
+        int epollFd = -1;
+        int inotifyFd = -1;
+        std::string directory;
+
+        std::array<Device, MaxGamepads> devices;
+        float deadzone = 0.15f;
+
+        // Slots opened by Watch or Open, outside a poll. Their GamepadConnectedEvents are delivered
+        // at the start of the next PollEvents, so they don't sit in the queue before the app polls.
+        bool polling = false;
+        uint32_t pendingConnections = 0;
+
+        void ScanDirectory();
+        void ReadInotify();
+
+        int OpenDevice(const std::string &path, bool requireGamepad);
+        void CloseDevice(int slot);
+        void ReadDevice(int slot);
+
+        void HandleInput(int slot, uint16_t type, uint16_t code, int32_t value, uint32_t serverTime,
+                         std::chrono::steady_clock::time_point hostTime);
+        void EmitButton(int slot, uint16_t code, GamepadButton button, bool down, uint32_t serverTime,
+                        std::chrono::steady_clock::time_point hostTime);
+        void EmitHat(int slot, uint16_t code, int32_t value, uint32_t serverTime, std::chrono::steady_clock::time_point hostTime);
+        void FlushAxes(int slot, uint32_t serverTime, std::chrono::steady_clock::time_point hostTime);
+        void Resync(int slot, std::chrono::steady_clock::time_point hostTime);
+
+        float Normalize(const Device &device, int code) const;
+
+    public:
+        explicit GamepadManager(Window &owner);
+        ~GamepadManager();
+
+        GamepadManager(const GamepadManager &) = delete;
+        GamepadManager &operator=(const GamepadManager &) = delete;
+
+        /// @brief Creates the epoll set, returns false if that failed
+        bool Create();
+
+        /// @brief Opens every gamepad in directory and watches it for hotplug
+        bool Watch(const std::string &directory);
+
+        /// @brief Opens path as a gamepad without checking its capabilities, returns the slot or -1
+        int Open(const std::string &path);
+
+        /// @brief Closes every open device, each with a GamepadDisconnectedEvent
+        void CloseAll();
+
+        /// @brief Reads everything the devices and the watch have ready
+        void PollEvents();
+
+        /// @brief True if an epoll-backed device or the watch has input that PollEvents would read
+        bool HasPendingInput();
+
+        /// @brief Readable whenever a device or the watch has something, for the backend's poll set
+        int GetFd() const { return epollFd; }
+
+        /// @brief Clamped to [0, MaxDeadzone], a deadzone of 1 would leave nothing to rescale
+        void SetDeadzone(float value) { deadzone = value < 0.0f ? 0.0f : value > MaxDeadzone ? MaxDeadzone : value; }
+
+        bool IsConnected(int gamepad) const;
+        const char *GetName(int gamepad) const;
+    };
+}
@@ -0,0 +1,92 @@
+#include <Nova/Nova.hpp>
+#include <Nova/Headless.hpp>
+#include <Flux/Flux.hpp>
+#include <cerrno>
+#include <cstdint>
+#include <poll.h>
+#include <unistd.h>
+
+namespace Nova
+{
+    HeadlessBackend::HeadlessBackend(Window &owner, size_t capacity)
+        : owner(owner), pendingEvents(capacity)
+    {
+    }
+
+    bool HeadlessBackend::Create(const std::string &, int, int)
+    {
+        return true;
+    }
+
+    bool HeadlessBackend::PollEvents()
+    {
+        Event event;
+        while (pendingEvents.Pop(event))
+        {
+            owner.DispatchEvent(event);
+        }
+
+        return true;
+    }
+
+    bool HeadlessBackend::Inject(const Event &event)
+    {
+        return pendingEvents.Push(event);
+    }
+
+    bool HeadlessBackend::HasPendingInput()
+    {
+        return !pendingEvents.Empty();
+    }
+
+    void HeadlessBackend::WaitForInput(const struct timespec *timeout, int wakeFd, int deviceFd)
+    {
+        struct pollfd fds[2];
+        fds[0].fd = wakeFd;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = deviceFd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+
+        // With neither descriptor there is nothing that could wake us, so only the timeout applies
+        if (ppoll(fds, 2, timeout, nullptr) < 0 && errno != EINTR)
+        {
+            Flux::Error("Waiting for events failed: {}", errno);
+            return;
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            uint64_t value;
+            ssize_t result = read(wakeFd, &value, sizeof(value));
+            (void)result;
+        }
+    }
+
+    void HeadlessBackend::LockCursor()
+    {
+        cursorLocked = true;
+    }
+
+    void HeadlessBackend::UnlockCursor()
+    {
+        cursorLocked = false;
+    }
+
+    void HeadlessBackend::SetResizable(bool)
+    {
+    }
+
+    SoftwareSurface HeadlessBackend::AcquireSurface()
+    {
+        pixels.resize(static_cast<size_t>(owner.width) * owner.height);
+
+        SoftwareSurface surface;
+        surface.pixels = pixels.data();
+        surface.width = owner.width;
+        surface.height = owner.height;
+        surface.stride = owner.width;
+        return surface;
+    }
+}
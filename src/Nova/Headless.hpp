@@ -0,0 +1,56 @@
+#pragma once
+#include <Nova/Event.hpp>
+#include <Nova/EventQueue.hpp>
+#include <Nova/SoftwareSurface.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Nova
+{
+    class Window;
+
+    /// @brief Backend without a native window, for running Nova where no display server exists.
+    /// Input comes from Inject and goes through the same PollEvents/PopEvent path as real input.
+    class HeadlessBackend
+    {
+    private:
+        Window &owner;
+
+        // Injected events waiting for the next PollEvents, allocated once like the window's queue
+        RingBuffer<Event> pendingEvents;
+
+        bool cursorLocked = false;
+
+        // Plain memory, so software rendering can run without a display
+        std::vector<uint32_t> pixels;
+
+    public:
+        HeadlessBackend(Window &owner, size_t capacity);
+
+        HeadlessBackend(const HeadlessBackend &) = delete;
+        HeadlessBackend &operator=(const HeadlessBackend &) = delete;
+
+        /// @brief Always succeeds, there is nothing to connect to
+        bool Create(const std::string &title, int width, int height);
+
+        /// @brief Dispatches everything injected since the last poll
+        bool PollEvents();
+
+        /// @brief Queues an event for the next PollEvents, returns false if too many are pending
+        bool Inject(const Event &event);
+
+        bool HasPendingInput();
+
+        /// @brief Sleeps until wakeFd becomes readable or the timeout passes
+        void WaitForInput(const struct timespec *timeout, int wakeFd, int deviceFd);
+
+        void LockCursor();
+        void UnlockCursor();
+
+        /// @brief Nothing to tell a window manager, resizes are injected as WindowResizeEvents
+        void SetResizable(bool resizable);
+
+        SoftwareSurface AcquireSurface();
+    };
+}
@@ -411,6 +411,7 @@ enum class Key
 }; // here
 
 
+/// @brief US layout approximation of the character a key types, use TextInputEvent for real text entry
 inline std::optional<char> KeyToChar(Key key, bool shiftPressed = false) {
     if (key >= Key::KEY_A && key <= Key::KEY_Z) {
         char base = shiftPressed ? 'A' : 'a';
@@ -0,0 +1,94 @@
+#pragma once
+#include <Nova/Key.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace Nova
+{
+    /// @brief One bit per Key, 512 bits in 8 words. Copying a whole keyboard is a single 64 byte
+    /// memcpy and combining masks works a word at a time.
+    class KeyboardState
+    {
+    public:
+        static constexpr size_t WordCount = static_cast<size_t>(Key::KEY_NUM_SCANCODES) / 64;
+
+        uint64_t words[WordCount] = {};
+
+        bool Test(Key key) const
+        {
+            size_t index = static_cast<size_t>(key);
+            return (words[index >> 6] >> (index & 63)) & 1;
+        }
+
+        void Set(Key key)
+        {
+            size_t index = static_cast<size_t>(key);
+            words[index >> 6] |= uint64_t(1) << (index & 63);
+        }
+
+        void Reset(Key key)
+        {
+            size_t index = static_cast<size_t>(key);
+            words[index >> 6] &= ~(uint64_t(1) << (index & 63));
+        }
+
+        void Clear()
+        {
+            for (size_t i = 0; i < WordCount; i++)
+            {
+                words[i] = 0;
+            }
+        }
+
+        bool Any() const
+        {
+            uint64_t result = 0;
+            for (size_t i = 0; i < WordCount; i++)
+            {
+                result |= words[i];
+            }
+            return result != 0;
+        }
+
+        /// @brief True if any key is set in both, e.g. state.Intersects(bindingMask)
+        bool Intersects(const KeyboardState &other) const
+        {
+            uint64_t result = 0;
+            for (size_t i = 0; i < WordCount; i++)
+            {
+                result |= words[i] & other.words[i];
+            }
+            return result != 0;
+        }
+
+        KeyboardState operator&(const KeyboardState &other) const
+        {
+            KeyboardState result;
+            for (size_t i = 0; i < WordCount; i++)
+            {
+                result.words[i] = words[i] & other.words[i];
+            }
+            return result;
+        }
+
+        KeyboardState operator|(const KeyboardState &other) const
+        {
+            KeyboardState result;
+            for (size_t i = 0; i < WordCount; i++)
+            {
+                result.words[i] = words[i] | other.words[i];
+            }
+            return result;
+        }
+
+        KeyboardState operator~() const
+        {
+            KeyboardState result;
+            for (size_t i = 0; i < WordCount; i++)
+            {
+                result.words[i] = ~words[i];
+            }
+            return result;
+        }
+    };
+}
@@ -1,277 +1,1000 @@
 #include <Nova/Nova.hpp>
 #include <Flux/Flux.hpp>
-#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <memory>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
 
 namespace Nova
 {
-    Window::Window(std::string title, int width, int height)
+    static Backend ResolveBackend(Backend requested)
     {
-        display = XOpenDisplay(nullptr);
-        if (display == nullptr)
+        if (requested != Backend::Auto)
         {
-            Flux::Error("Unable to open X display");
-            exit(1);
+            return requested;
         }
 
-        screen = DefaultScreen(display);
-        X11Window root = RootWindow(display, screen);
+        // X11 stays the default until renderers accept Wayland handles, NOVA_BACKEND=wayland opts in
+        const char *name = getenv("NOVA_BACKEND");
+        if (name == nullptr)
+        {
+            return Backend::X11;
+        }
 
-        window = XCreateSimpleWindow(display, root, 100, 100, width, height, 1,
-                                     BlackPixel(display, screen),
-                                     BlackPixel(display, screen));
+        if (strcmp(name, "wayland") == 0)
+        {
+            return Backend::Wayland;
+        }
+        if (strcmp(name, "xcb") == 0)
+        {
+            return Backend::Xcb;
+        }
+        if (strcmp(name, "headless") == 0)
+        {
+            return Backend::Headless;
+        }
+        if (strcmp(name, "x11") != 0)
+        {
+            Flux::Error("Unknown NOVA_BACKEND '{}', using X11", name);
+        }
+        return Backend::X11;
+    }
 
-        XStoreName(display, window, title.c_str());
+    template <typename Visitor>
+    decltype(auto) Window::VisitBackend(Visitor &&visitor)
+    {
+        switch (backend)
+        {
+#ifdef NOVA_HAS_XCB
+        case Backend::Xcb:
+            return visitor(*xcb);
+#endif
+#ifdef NOVA_WAYLAND_BACKEND
+        case Backend::Wayland:
+            return visitor(*wayland);
+#endif
+        case Backend::Headless:
+            return visitor(*headless);
+        default:
+            return visitor(*x11);
+        }
+    }
 
-        // Register WM_DELETE_WINDOW protocol
-        Atom WM_DELETE_WINDOW = XInternAtom(display, "WM_DELETE_WINDOW", False);
-        XSetWMProtocols(display, window, &WM_DELETE_WINDOW, 1);
+    Window::Window(std::string title, int width, int height, Backend backend)
+        : eventQueue(EventQueueCapacity)
+    {
+        this->width = width;
+        this->height = height;
 
-        // Select input events
-        XSelectInput(display, window,
-             ExposureMask | KeyPressMask | KeyReleaseMask | StructureNotifyMask |
-             ButtonPressMask | ButtonReleaseMask | PointerMotionMask);
+        wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (wakeFd == -1)
+        {
+            Flux::Error("Unable to create wake eventfd, PostEmptyEvent will not wake WaitEvents");
+        }
 
+        this->backend = ResolveBackend(backend);
 
-        // Set size hints to prevent resizing
-        XSizeHints size_hints;
-        size_hints.flags = PMinSize | PMaxSize;
-        size_hints.min_width = size_hints.max_width = width;
-        size_hints.min_height = size_hints.max_height = height;
+        if (this->backend == Backend::Headless)
+        {
+            headless = std::make_unique<HeadlessBackend>(*this, EventQueueCapacity);
+            headless->Create(title, width, height);
+            return;
+        }
 
-        XSetWMNormalHints(display, window, &size_hints);
+        if (this->backend == Backend::Wayland)
+        {
+#ifdef NOVA_WAYLAND_BACKEND
+            wayland = std::make_unique<WaylandBackend>(*this);
+            if (wayland->Create(title, width, height))
+            {
+                return;
+            }
 
-        XMapWindow(display, window);
-        XFlush(display); // Important: ensure window is created before WebGPU init
+            Flux::Error("Unable to connect to a Wayland compositor, falling back to X11");
+            wayland.reset();
+#else
+            Flux::Error("Nova was built without Wayland support, falling back to X11");
+#endif
+            this->backend = Backend::X11;
+        }
 
-        backend = Backend::X11;
+        if (this->backend == Backend::Xcb)
+        {
+#ifdef NOVA_HAS_XCB
+            xcb = std::make_unique<XcbBackend>(*this);
+            if (xcb->Create(title, width, height))
+            {
+                return;
+            }
 
-        X11PlatformData *data = new X11PlatformData();
-        data->display = display;
-        data->window = window;
-        platformData = data;
+            Flux::Error("Unable to connect to the X server through xcb, falling back to Xlib");
+            xcb.reset();
+#else
+            Flux::Error("Nova was built without xcb support, falling back to Xlib");
+#endif
+            this->backend = Backend::X11;
+        }
+
+        x11 = std::make_unique<X11Backend>(*this);
+        if (!x11->Create(title, width, height))
+        {
+            Flux::Error("Unable to open X display, window \"{}\" was not created", title);
+            x11.reset();
 
+            // Every call stays safe on a headless backend, PollEvents reports the window as closed
+            valid = false;
+            this->backend = Backend::Headless;
+            headless = std::make_unique<HeadlessBackend>(*this, EventQueueCapacity);
+        }
+    }
+
+    Window::Window(DisplayContext &context, std::string title, int width, int height)
+        : eventQueue(EventQueueCapacity)
+    {
         this->width = width;
         this->height = height;
+
+        wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (wakeFd == -1)
+        {
+            Flux::Error("Unable to create wake eventfd, PostEmptyEvent will not wake WaitEvents");
+        }
+
+        backend = Backend::X11;
+        x11 = std::make_unique<X11Backend>(*this);
+        if (!x11->Create(context, title, width, height))
+        {
+            Flux::Error("Display context has no X display, window \"{}\" was not created", title);
+            x11.reset();
+
+            valid = false;
+            backend = Backend::Headless;
+            headless = std::make_unique<HeadlessBackend>(*this, EventQueueCapacity);
+        }
+    }
+
+    Window::~Window()
+    {
+        // Backends are destroyed first, they may still dispatch into the queue while shutting down
+        x11.reset();
+#ifdef NOVA_HAS_XCB
+        xcb.reset();
+#endif
+#ifdef NOVA_WAYLAND_BACKEND
+        wayland.reset();
+#endif
+        headless.reset();
+
+        if (wakeFd != -1)
+        {
+            close(wakeFd);
+        }
+    }
+
+    bool Window::IsValid() const
+    {
+        return valid;
+    }
+
+    NativeHandles Window::GetNativeHandles() const
+    {
+        switch (backend)
+        {
+#ifdef NOVA_WAYLAND_BACKEND
+        case Backend::Wayland:
+        {
+            WaylandHandles handles;
+            handles.display = wayland->GetDisplay();
+            handles.surface = wayland->GetSurface();
+            return handles;
+        }
+#endif
+#ifdef NOVA_HAS_XCB
+        case Backend::Xcb:
+        {
+            XcbHandles handles;
+            handles.connection = xcb->GetConnection();
+            handles.window = xcb->GetWindow();
+            return handles;
+        }
+#endif
+        case Backend::X11:
+        {
+            X11Handles handles;
+            handles.display = x11->GetDisplay();
+            handles.window = x11->GetWindow();
+            return handles;
+        }
+        default:
+            return HeadlessHandles();
+        }
+    }
+
+    static bool IsGamepadEvent(const Event &event)
+    {
+        return std::holds_alternative<GamepadConnectedEvent>(event) ||
+               std::holds_alternative<GamepadDisconnectedEvent>(event) ||
+               std::holds_alternative<GamepadButtonDownEvent>(event) ||
+               std::holds_alternative<GamepadButtonUpEvent>(event) ||
+               std::holds_alternative<GamepadAxisEvent>(event);
     }
 
     bool Window::PollEvents()
     {
-        if (!eventStack.empty())
+        if (!eventQueue.Empty())
         {
             Flux::Error("Not all events handled!");
         }
 
-        while (XPending(display) > 0)
-        { // Changed to 'while' to process all events
-            XEvent event;
-            XNextEvent(display, &event);
+#ifdef NOVA_INSTRUMENTATION
+        auto pollStart = std::chrono::steady_clock::now();
+        frameStats = FrameStats();
+#endif
+
+        canCoalesceMotion = false;
+        canCoalesceScroll = false;
+        motionSamples.clear();
+        keysPressed.Clear();
+        keysReleased.Clear();
+        if (actionMap)
+        {
+            actionMap->BeginFrame();
+        }
 
-            switch (event.type)
-            {
-            case KeyPress:
+        polling = true;
+        if (gamepadsClosing)
+        {
+            CloseGamepads();
+        }
+
+        liveInputMuted = replayer != nullptr;
+        bool open = VisitBackend([](auto &impl) { return impl.PollEvents(); }) && valid;
+        if (gamepads)
+        {
+            gamepads->PollEvents();
+        }
+        liveInputMuted = false;
+
+        if (replayer)
+        {
+            ReplayEvents();
+        }
+
+        FlushResize();
+
+        if (droppedEvents > 0)
+        {
+            Flux::Error("Event queue full, dropped {} events", droppedEvents);
+#ifdef NOVA_INSTRUMENTATION
+            frameStats.eventsDropped = droppedEvents;
+#endif
+            droppedEvents = 0;
+        }
+
+        // Requested by a listener while the subsystem was still on the stack
+        if (gamepadsClosing)
+        {
+            CloseGamepads();
+        }
+        polling = false;
+        if (replayStopping)
+        {
+            replayStopping = false;
+            replayer.reset();
+        }
+
+#ifdef NOVA_INSTRUMENTATION
+        frameStats.pollDuration = std::chrono::steady_clock::now() - pollStart;
+#endif
+
+        return open;
+    }
+
+    void Window::DispatchEvent(const Event &event)
+    {
+        // Resizes describe the real window, not input, so they are delivered during a replay as well
+        if (liveInputMuted && !std::holds_alternative<WindowResizeEvent>(event))
+        {
+            return;
+        }
+
+        // The rest of a poll after DisableGamepads, the manager is only destroyed once it returns
+        if (gamepadsClosing && IsGamepadEvent(event))
+        {
+            return;
+        }
+
+        if (recorder)
+        {
+            recorder->Record(event);
+        }
+
+#ifdef NOVA_INSTRUMENTATION
+        frameStats.eventsProcessed++;
+
+        const EventBase &base = GetEventBase(event);
+        if (latencyHistograms && base.serverTime != 0)
+        {
+            // Server timestamps are CLOCK_MONOTONIC milliseconds truncated to 32 bits
+            uint32_t hostMilliseconds = static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(base.hostTime.time_since_epoch()).count());
+            int32_t delivery = static_cast<int32_t>(hostMilliseconds - base.serverTime);
+            deliveryLatency.Record(std::chrono::milliseconds(delivery));
+        }
+#endif
+
+        if (const MouseMoveEvent *motion = std::get_if<MouseMoveEvent>(&event))
+        {
+            QueueMotion(*motion);
+        }
+        else if (const MouseScrollEvent *scroll = std::get_if<MouseScrollEvent>(&event))
+        {
+            QueueScroll(*scroll);
+        }
+        else if (const WindowResizeEvent *resize = std::get_if<WindowResizeEvent>(&event))
+        {
+            // Only the last size of a burst matters, FlushResize queues it
+            if (resize->width == (resizePending ? pendingWidth : width) &&
+                resize->height == (resizePending ? pendingHeight : height))
             {
-                KeySym keysym = XLookupKeysym(&event.xkey, 0);
-                Key key = X11KeySymToNovaKey(keysym);
+                return;
+            }
 
-                if (key == Key::KEY_LSHIFT || key == Key::KEY_RSHIFT) {
-                    shift = true;
-                }
+            resizePending = true;
+            pendingWidth = resize->width;
+            pendingHeight = resize->height;
+            lastResize = resize->hostTime;
+        }
+        else if (const KeyDownEvent *keyDown = std::get_if<KeyDownEvent>(&event))
+        {
+            // A press for a key that is already down is auto-repeat, not a new press
+            if (keys.Test(keyDown->key))
+            {
+                // Only the most recently pressed key repeats
+                repeatCount = repeatKey == keyDown->key ? repeatCount + 1 : 1;
+                repeatKey = keyDown->key;
 
-                // If key is not already marked as pressed, it's a real press
-                if (key != Key::KEY_UNKNOWN && !keyStates[key])
+                if (keyRepeatEvents)
                 {
-                    KeyDownEvent *keyDownEvent = new KeyDownEvent();
-                    keyDownEvent->key = key;
-                    keyDownEvent->shift = shift;
-                    eventStack.push(keyDownEvent);
-                    keyStates[key] = true;
+                    KeyRepeatEvent repeat;
+                    repeat.key = keyDown->key;
+                    repeat.shift = keyDown->shift;
+                    repeat.modifiers = keyDown->modifiers;
+                    repeat.repeatCount = repeatCount;
+                    repeat.serverTime = keyDown->serverTime;
+                    repeat.hostTime = keyDown->hostTime;
+                    QueueEvent(repeat);
                 }
-                break;
+                return;
             }
 
-            case KeyRelease:
-            {
-                KeySym keysym = XLookupKeysym(&event.xkey, 0);
-                Key key = X11KeySymToNovaKey(keysym);
+            repeatKey = Key::KEY_UNKNOWN;
+            keys.Set(keyDown->key);
+            keysPressed.Set(keyDown->key);
+            QueueEvent(event);
 
-                if (key == Key::KEY_LSHIFT || key == Key::KEY_RSHIFT) {
-                    shift = false;
-                }
+            if (actionMap)
+            {
+                actionMap->KeyChanged(keyDown->key, keys);
+                QueueActionChanges(*keyDown);
+            }
+        }
+        else if (const KeyUpEvent *keyUp = std::get_if<KeyUpEvent>(&event))
+        {
+            if (!keys.Test(keyUp->key))
+            {
+                return;
+            }
 
-                // Use XEventsQueued + Peek to filter out auto-repeat releases
-                if (XEventsQueued(display, QueuedAfterReading))
-                {
-                    XEvent next_event;
-                    XPeekEvent(display, &next_event);
-
-                    if (next_event.type == KeyPress &&
-                        next_event.xkey.keycode == event.xkey.keycode &&
-                        next_event.xkey.time == event.xkey.time)
-                    {
-                        // Auto-repeat event, skip this release
-                        break;
-                    }
-                }
+            keys.Reset(keyUp->key);
+            keysReleased.Set(keyUp->key);
+            QueueEvent(event);
 
-                if (key != Key::KEY_UNKNOWN && keyStates[key])
-                {
-                    KeyUpEvent *keyUpEvent = new KeyUpEvent();
-                    keyUpEvent->key = key;
-                    keyUpEvent->shift = shift;
-                    eventStack.push(keyUpEvent);
-                    keyStates[key] = false;
-                }
-                break;
+            if (actionMap)
+            {
+                actionMap->KeyChanged(keyUp->key, keys);
+                QueueActionChanges(*keyUp);
             }
+        }
+        else if (const MouseButtonDownEvent *buttonDown = std::get_if<MouseButtonDownEvent>(&event))
+        {
+            QueueEvent(event);
 
-            case MotionNotify:
+            if (actionMap)
             {
-                if (cursorLocked)
-                {
-                    int centerX = width / 2;
-                    int centerY = height / 2;
-
-                    int dx = event.xmotion.x - centerX;
-                    int dy = event.xmotion.y - centerY;
-
-                    if (dx != 0 || dy != 0)
-                    {
-                        // Push delta movement event
-                        MouseMoveEvent* mouseMoveEvent = new MouseMoveEvent();
-                        mouseMoveEvent->x = dx;
-                        mouseMoveEvent->y = dy;
-                        eventStack.push(mouseMoveEvent);
-
-                        // Warp back to center
-                        XWarpPointer(display, None, window, 0, 0, 0, 0, centerX, centerY);
-                        XFlush(display);
-                    }
-                }
-                else
-                {
-                    MouseMoveEvent *mouseMoveEvent = new MouseMoveEvent();
-                    mouseMoveEvent->x = event.xmotion.x;
-                    mouseMoveEvent->y = event.xmotion.y;
-                    eventStack.push(mouseMoveEvent);
-                }
+                actionMap->ButtonChanged(buttonDown->button, true, keys);
+                QueueActionChanges(*buttonDown);
+            }
+        }
+        else if (const MouseButtonUpEvent *buttonUp = std::get_if<MouseButtonUpEvent>(&event))
+        {
+            QueueEvent(event);
 
-                break;
+            if (actionMap)
+            {
+                actionMap->ButtonChanged(buttonUp->button, false, keys);
+                QueueActionChanges(*buttonUp);
             }
+        }
+        else
+        {
+            QueueEvent(event);
+        }
+    }
 
+    bool Window::QueueEvent(const Event &event)
+    {
+        canCoalesceMotion = false;
+        canCoalesceScroll = false;
 
-            case ButtonPress:
+        const Listener &listener = listeners[event.index()];
+        if (listener.invoke)
+        {
+#ifdef NOVA_INSTRUMENTATION
+            if (latencyHistograms)
             {
-                MouseButtonDownEvent *mouseDownEvent = new MouseButtonDownEvent();
+                queueLatency.Record(std::chrono::steady_clock::now() - GetEventBase(event).hostTime);
+            }
+#endif
+            listener.invoke(listener, event);
+            return false;
+        }
 
-                if (event.xbutton.button == Button1)
-                {
-                    // Left click
-                    mouseDownEvent->button = MouseButton::Left;
-                }
-                else if (event.xbutton.button == Button2)
+        if (!eventQueue.Push(event))
+        {
+            droppedEvents++;
+            return false;
+        }
+        return true;
+    }
+
+    void Window::QueueActionChanges(const EventBase &cause)
+    {
+        for (ActionId action : actionMap->GetChanges())
+        {
+            ActionEvent actionEvent;
+            actionEvent.action = action;
+            actionEvent.value = actionMap->GetValue(action);
+            actionEvent.down = actionEvent.value != 0.0f;
+            actionEvent.serverTime = cause.serverTime;
+            actionEvent.hostTime = cause.hostTime;
+            QueueEvent(actionEvent);
+        }
+        actionMap->ClearChanges();
+    }
+
+    void Window::QueueMotion(const MouseMoveEvent &motion)
+    {
+        if (motionBatching)
+        {
+            MotionSample sample;
+            sample.x = motion.relative ? motion.deltaX : motion.x;
+            sample.y = motion.relative ? motion.deltaY : motion.y;
+            sample.relative = motion.relative;
+            sample.serverTime = motion.serverTime;
+            motionSamples.push_back(sample);
+        }
+
+        // Only the event at the back of the queue can be merged, and only if nothing else was queued after it
+        if (motionCoalescing != MotionCoalescing::Disabled && canCoalesceMotion)
+        {
+            MouseMoveEvent *last = std::get_if<MouseMoveEvent>(&eventQueue.Back());
+
+            bool inBucket = motionCoalescing == MotionCoalescing::PerPoll ||
+                            std::chrono::milliseconds(motion.serverTime - motionBucketStart) < motionBucket;
+
+            if (last != nullptr && last->relative == motion.relative && inBucket)
+            {
+                if (motion.relative)
                 {
-                    // Middle click
-                    mouseDownEvent->button = MouseButton::Middle;
+                    last->x += motion.x;
+                    last->y += motion.y;
+                    last->deltaX += motion.deltaX;
+                    last->deltaY += motion.deltaY;
                 }
-                else if (event.xbutton.button == Button3)
+                else
                 {
-                    // Right click
-                    mouseDownEvent->button = MouseButton::Right;
+                    last->x = motion.x;
+                    last->y = motion.y;
                 }
 
-                eventStack.push(mouseDownEvent);
-                break;
+                last->serverTime = motion.serverTime;
+                last->hostTime = motion.hostTime;
+                last->samples += motion.samples;
+#ifdef NOVA_INSTRUMENTATION
+                frameStats.eventsCoalesced++;
+#endif
+                return;
             }
-            case ButtonRelease:
+        }
+
+        if (QueueEvent(motion))
+        {
+            canCoalesceMotion = true;
+            motionBucketStart = motion.serverTime;
+        }
+    }
+
+    void Window::QueueScroll(const MouseScrollEvent &scroll)
+    {
+        // Like motion, only a scroll event still at the back of the queue can take more deltas
+        if (scrollAccumulation && canCoalesceScroll)
+        {
+            MouseScrollEvent *last = std::get_if<MouseScrollEvent>(&eventQueue.Back());
+            if (last != nullptr && last->precise == scroll.precise)
             {
-                MouseButtonUpEvent *mouseUpEvent = new MouseButtonUpEvent();
+                last->deltaX += scroll.deltaX;
+                last->deltaY += scroll.deltaY;
+                last->serverTime = scroll.serverTime;
+                last->hostTime = scroll.hostTime;
+                last->samples += scroll.samples;
+#ifdef NOVA_INSTRUMENTATION
+                frameStats.eventsCoalesced++;
+#endif
+                return;
+            }
+        }
 
-                if (event.xbutton.button == Button1)
-                {
-                    // Left click
-                    mouseUpEvent->button = MouseButton::Left;
-                }
-                else if (event.xbutton.button == Button2)
-                {
-                    // Middle click
-                    mouseUpEvent->button = MouseButton::Middle;
-                }
-                else if (event.xbutton.button == Button3)
-                {
-                    // Right click
-                    mouseUpEvent->button = MouseButton::Right;
-                }
+        if (QueueEvent(scroll))
+        {
+            canCoalesceScroll = true;
+        }
+    }
+
+    bool Window::HasEvents()
+    {
+        return !eventQueue.Empty();
+    }
+
+    void Window::SetKeyRepeatEvents(bool enabled)
+    {
+        keyRepeatEvents = enabled;
+    }
+
+    bool Window::IsKeyDown(Key key) const
+    {
+        return keys.Test(key);
+    }
+
+    KeyboardState Window::GetKeyboardState() const
+    {
+        return keys;
+    }
+
+    const KeyboardState &Window::GetKeysPressed() const
+    {
+        return keysPressed;
+    }
+
+    const KeyboardState &Window::GetKeysReleased() const
+    {
+        return keysReleased;
+    }
+
+    bool Window::InjectEvent(const Event &event)
+    {
+        if (!headless)
+        {
+            Flux::Error("Injecting events is only supported by the headless backend");
+            return false;
+        }
+
+        return headless->Inject(event);
+    }
+
+    std::optional<Event> Window::PopEvent()
+    {
+        Event value;
+        if (!eventQueue.Pop(value))
+        {
+            return std::nullopt;
+        }
+
+#ifdef NOVA_INSTRUMENTATION
+        if (latencyHistograms)
+        {
+            queueLatency.Record(std::chrono::steady_clock::now() - GetEventBase(value).hostTime);
+        }
+#endif
+
+        return value;
+    }
 
-                eventStack.push(mouseUpEvent);
-                break;
+    GamepadManager *Window::GetGamepads()
+    {
+        // Used again before a poll closed them, the manager stays
+        gamepadsClosing = false;
+
+        if (!gamepads)
+        {
+            gamepads = std::make_unique<GamepadManager>(*this);
+            if (!gamepads->Create())
+            {
+                gamepads.reset();
             }
+        }
+        return gamepads.get();
+    }
 
-            case ClientMessage:
+    bool Window::EnableGamepads(const std::string &directory)
+    {
+        GamepadManager *manager = GetGamepads();
+        return manager != nullptr && manager->Watch(directory);
+    }
+
+    void Window::DisableGamepads()
+    {
+        // A listener may run inside the manager's PollEvents, and disconnects queued outside a poll
+        // would sit in the queue before the app polls, so the manager is closed by PollEvents
+        gamepadsClosing = gamepads != nullptr;
+    }
+
+    void Window::CloseGamepads()
+    {
+        // Every open pad is announced as disconnected, so apps tracking them from the events let go
+        // of the pad and of the buttons they mirrored
+        gamepadsClosing = false;
+        gamepads->CloseAll();
+        gamepads.reset();
+    }
+
+    int Window::OpenGamepad(const std::string &path)
+    {
+        GamepadManager *manager = GetGamepads();
+        return manager != nullptr ? manager->Open(path) : -1;
+    }
+
+    void Window::SetGamepadDeadzone(float deadzone)
+    {
+        if (GamepadManager *manager = GetGamepads())
+        {
+            manager->SetDeadzone(deadzone);
+        }
+    }
+
+    bool Window::IsGamepadConnected(int gamepad) const
+    {
+        return gamepads && !gamepadsClosing && gamepads->IsConnected(gamepad);
+    }
+
+    const char *Window::GetGamepadName(int gamepad) const
+    {
+        return gamepads ? gamepads->GetName(gamepad) : "";
+    }
+
+    void Window::SetActionMap(ActionMap map)
+    {
+        actionMap = std::make_unique<ActionMap>(std::move(map));
+        if (!actionMap->IsCompiled())
+        {
+            actionMap->Compile();
+        }
+
+        // Keys already held count from the start, without events for them
+        actionMap->Sync(keys);
+    }
+
+    void Window::ClearActionMap()
+    {
+        actionMap.reset();
+    }
+
+    bool Window::IsActionDown(ActionId action) const
+    {
+        return actionMap && actionMap->IsDown(action);
+    }
+
+    bool Window::WasActionPressed(ActionId action) const
+    {
+        return actionMap && actionMap->WasPressed(action);
+    }
+
+    bool Window::WasActionReleased(ActionId action) const
+    {
+        return actionMap && actionMap->WasReleased(action);
+    }
+
+    float Window::GetActionValue(ActionId action) const
+    {
+        return actionMap ? actionMap->GetValue(action) : 0.0f;
+    }
+
+    bool Window::StartRecording(const std::string &path)
+    {
+        recorder = std::make_unique<InputRecorder>();
+        if (!recorder->Open(path))
+        {
+            recorder.reset();
+            return false;
+        }
+        return true;
+    }
+
+    void Window::StopRecording()
+    {
+        recorder.reset();
+    }
+
+    bool Window::StartReplay(const std::string &path, ReplaySpeed speed)
+    {
+        replayStopping = false;
+        replayer = std::make_unique<InputReplayer>();
+        if (!replayer->Open(path, speed))
+        {
+            replayer.reset();
+            return false;
+        }
+        return true;
+    }
+
+    void Window::StopReplay()
+    {
+        // A listener may run inside ReplayEvents, the replayer is destroyed when the poll ends
+        if (polling)
+        {
+            replayStopping = replayer != nullptr;
+            return;
+        }
+
+        replayer.reset();
+    }
+
+    bool Window::IsReplaying() const
+    {
+        return replayer != nullptr && !replayStopping;
+    }
+
+    void Window::ReplayEvents()
+    {
+        auto now = std::chrono::steady_clock::now();
+
+        // At most what fits in the queue per poll, at fast speed the rest follows in the next poll.
+        // Counted per record, events handed to On<T> listeners never reach the queue.
+        size_t budget = eventQueue.Capacity() - eventQueue.Size();
+        Event event;
+        // A listener can stop the replay or start another one that fails to open
+        for (size_t replayed = 0; replayed < budget && replayer && !replayStopping && replayer->Next(event, now);
+             replayed++)
+        {
+            // The recorded window size is not this window's, the live resizes keep width and height right
+            if (!std::holds_alternative<WindowResizeEvent>(event))
             {
-                Atom WM_DELETE_WINDOW = XInternAtom(display, "WM_DELETE_WINDOW", False);
-                if (static_cast<Atom>(event.xclient.data.l[0]) == WM_DELETE_WINDOW)
-                {
-                    return false;
-                }
-                break;
+                DispatchEvent(event);
             }
+        }
+
+        if (replayer && !replayStopping && replayer->Finished())
+        {
+            Flux::Info("Input replay finished");
+            replayer.reset();
+        }
+    }
+
+    const FrameStats &Window::GetFrameStats() const
+    {
+        return frameStats;
+    }
+
+    void Window::SetLatencyHistograms(bool enabled)
+    {
+        latencyHistograms = enabled;
+    }
+
+    const LatencyHistogram &Window::GetQueueLatency() const
+    {
+        return queueLatency;
+    }
+
+    const LatencyHistogram &Window::GetDeliveryLatency() const
+    {
+        return deliveryLatency;
+    }
+
+    void Window::ResetLatencyHistograms()
+    {
+        queueLatency.Reset();
+        deliveryLatency.Reset();
+    }
+
+    void Window::FlushResize()
+    {
+        if (!resizePending || ResizeSettleTime() > std::chrono::nanoseconds::zero())
+        {
+            return;
+        }
+
+        resizePending = false;
+        width = pendingWidth;
+        height = pendingHeight;
+        if (x11)
+        {
+            x11->SetLockCenter(width, height);
+        }
+
+        WindowResizeEvent resizeEvent;
+        resizeEvent.width = width;
+        resizeEvent.height = height;
+        resizeEvent.hostTime = lastResize;
+        QueueEvent(resizeEvent);
+    }
 
-            case ConfigureNotify:
-                // Handle window configuration changes if needed
-                break;
+    std::chrono::nanoseconds Window::ResizeSettleTime() const
+    {
+        return lastResize + resizeDebounce - std::chrono::steady_clock::now();
+    }
+
+    std::chrono::nanoseconds Window::PendingDeadline() const
+    {
+        std::chrono::nanoseconds deadline = std::chrono::nanoseconds::max();
+        if (resizePending)
+        {
+            deadline = std::min(deadline, ResizeSettleTime());
+        }
+        if (replayer)
+        {
+            deadline = std::min(deadline, replayer->TimeUntilNext(std::chrono::steady_clock::now()));
+        }
+        return deadline;
+    }
+
+    bool Window::WaitEvents()
+    {
+        // Held back resizes and replayed events have to be delivered even if nothing else arrives
+        std::chrono::nanoseconds deadline = PendingDeadline();
+        if (deadline != std::chrono::nanoseconds::max())
+        {
+            return WaitEventsTimeout(deadline);
+        }
+
+        if (!HasPendingInput())
+        {
+            WaitForInput(nullptr);
+        }
+
+        return PollEvents();
+    }
+
+    bool Window::WaitEventsTimeout(std::chrono::nanoseconds timeout)
+    {
+        if (!HasPendingInput())
+        {
+            timeout = std::min(timeout, PendingDeadline());
+
+            if (timeout < std::chrono::nanoseconds::zero())
+            {
+                timeout = std::chrono::nanoseconds::zero();
             }
+
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+
+            struct timespec ts;
+            ts.tv_sec = seconds.count();
+            ts.tv_nsec = (timeout - seconds).count();
+            WaitForInput(&ts);
         }
-        return true;
+
+        return PollEvents();
     }
 
-    bool Window::HasEvents()
+    void Window::PostEmptyEvent()
     {
-        return !eventStack.empty();
+        if (wakeFd == -1)
+        {
+            return;
+        }
+
+        uint64_t value = 1;
+        ssize_t written = write(wakeFd, &value, sizeof(value));
+        (void)written;
     }
 
-    Event *Window::PopEvent()
+    void Window::SetMotionCoalescing(MotionCoalescing mode, std::chrono::microseconds bucket)
     {
-        Event *value = eventStack.top();
-        eventStack.pop();
+        motionCoalescing = mode;
+        motionBucket = bucket;
+        canCoalesceMotion = false;
+    }
 
-        return value;
+    void Window::SetScrollAccumulation(bool enabled)
+    {
+        scrollAccumulation = enabled;
+        canCoalesceScroll = false;
+    }
+
+    void Window::SetMotionBatching(bool enabled)
+    {
+        motionBatching = enabled;
+        if (enabled)
+        {
+            motionSamples.reserve(EventQueueCapacity);
+        }
+        else
+        {
+            motionSamples.clear();
+        }
+    }
+
+    const std::vector<MotionSample> &Window::GetMotionSamples() const
+    {
+        return motionSamples;
+    }
+
+    bool Window::HasPendingInput()
+    {
+        return !eventQueue.Empty() || VisitBackend([](auto &impl) { return impl.HasPendingInput(); }) ||
+               (gamepads && gamepads->HasPendingInput());
+    }
+
+    void Window::WaitForInput(const struct timespec *timeout)
+    {
+        int deviceFd = gamepads ? gamepads->GetFd() : -1;
+        VisitBackend([&](auto &impl) { impl.WaitForInput(timeout, wakeFd, deviceFd); });
     }
 
-    void Nova::Window::LockCursor() {
-        if (cursorLocked) return;
+    void Window::LockCursor()
+    {
+        VisitBackend([](auto &impl) { impl.LockCursor(); });
+    }
 
-        // Create invisible cursor
-        Pixmap bm_no;
-        XColor black;
-        static char no_data[] = { 0,0,0,0,0,0,0,0 };
-        black.red = black.green = black.blue = 0;
-        bm_no = XCreateBitmapFromData(display, window, no_data, 8, 8);
-        invisibleCursor = XCreatePixmapCursor(display, bm_no, bm_no, &black, &black, 0, 0);
-        XDefineCursor(display, window, invisibleCursor);
-        XFreePixmap(display, bm_no);
+    void Window::UnlockCursor()
+    {
+        VisitBackend([](auto &impl) { impl.UnlockCursor(); });
+    }
 
-        // Grab pointer
-        XGrabPointer(display, window, True,
-                    PointerMotionMask | ButtonPressMask | ButtonReleaseMask,
-                    GrabModeAsync, GrabModeAsync, window, None, CurrentTime);
+    void Window::SetResizable(bool resizable)
+    {
+        VisitBackend([&](auto &impl) { impl.SetResizable(resizable); });
+    }
 
-        // Move to center
-        int centerX = width / 2;
-        int centerY = height / 2;
-        XWarpPointer(display, None, window, 0, 0, 0, 0, centerX, centerY);
-        XFlush(display);
+    void Window::SetResizeDebounce(std::chrono::milliseconds debounce)
+    {
+        resizeDebounce = debounce;
+    }
 
-        cursorLocked = true;
+    SoftwareSurface Window::GetSoftwareSurface()
+    {
+        if (x11)
+        {
+            return x11->AcquireSurface();
+        }
+        if (headless)
+        {
+            return headless->AcquireSurface();
+        }
+
+        Flux::Error("Software surfaces are only supported on X11 and headless windows");
+        return SoftwareSurface();
     }
 
-    void Nova::Window::UnlockCursor() {
-        if (!cursorLocked) return;
+    void Window::Present()
+    {
+        if (x11)
+        {
+            x11->Present();
+        }
+    }
 
-        XUngrabPointer(display, CurrentTime);
-        XUndefineCursor(display, window);
-        XFreeCursor(display, invisibleCursor);
+    bool Window::StartInputThread()
+    {
+        if (!x11)
+        {
+            Flux::Error("The input thread is only supported on X11");
+            return false;
+        }
 
-        cursorLocked = false;
+        return x11->StartInputThread();
     }
 
-}
\ No newline at end of file
+    void Window::StopInputThread()
+    {
+        if (x11)
+        {
+            x11->StopInputThread();
+        }
+    }
+}
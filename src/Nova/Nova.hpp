@@ -1,363 +1,410 @@
 #pragma once
-#include <wayland-client.h>
-#include <wayland-egl.h>
 #include <Flux/Flux.hpp>
 #include <Nova/Key.hpp>
+#include <Nova/Event.hpp>
+#include <Nova/Actions.hpp>
+#include <Nova/EventQueue.hpp>
+#include <Nova/KeyboardState.hpp>
+#include <Nova/SoftwareSurface.hpp>
+#include <Nova/Stats.hpp>
+#include <Nova/Recording.hpp>
+#include <Nova/X11.hpp>
+#include <Nova/DisplayContext.hpp>
+#include <Nova/Headless.hpp>
+#include <Nova/Gamepad.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
-#include <stack>
-#include <unordered_map>
-#include <X11/Xlib.h>
-#include <X11/Xutil.h>
+#include <variant>
+#include <vector>
 
-using X11Window = ::Window;
+#ifdef NOVA_HAS_XCB
+#include <Nova/Xcb.hpp>
+#endif
 
-namespace Nova
-{
-    // Helper function to convert X11 KeySym to Nova::Key
-    static Key X11KeySymToNovaKey(KeySym keysym)
-    {
-        switch (keysym)
-        {
-        case XK_a:
-        case XK_A:
-            return Key::KEY_A;
-        case XK_b:
-        case XK_B:
-            return Key::KEY_B;
-        case XK_c:
-        case XK_C:
-            return Key::KEY_C;
-        case XK_d:
-        case XK_D:
-            return Key::KEY_D;
-        case XK_e:
-        case XK_E:
-            return Key::KEY_E;
-        case XK_f:
-        case XK_F:
-            return Key::KEY_F;
-        case XK_g:
-        case XK_G:
-            return Key::KEY_G;
-        case XK_h:
-        case XK_H:
-            return Key::KEY_H;
-        case XK_i:
-        case XK_I:
-            return Key::KEY_I;
-        case XK_j:
-        case XK_J:
-            return Key::KEY_J;
-        case XK_k:
-        case XK_K:
-            return Key::KEY_K;
-        case XK_l:
-        case XK_L:
-            return Key::KEY_L;
-        case XK_m:
-        case XK_M:
-            return Key::KEY_M;
-        case XK_n:
-        case XK_N:
-            return Key::KEY_N;
-        case XK_o:
-        case XK_O:
-            return Key::KEY_O;
-        case XK_p:
-        case XK_P:
-            return Key::KEY_P;
-        case XK_q:
-        case XK_Q:
-            return Key::KEY_Q;
-        case XK_r:
-        case XK_R:
-            return Key::KEY_R;
-        case XK_s:
-        case XK_S:
-            return Key::KEY_S;
-        case XK_t:
-        case XK_T:
-            return Key::KEY_T;
-        case XK_u:
-        case XK_U:
-            return Key::KEY_U;
-        case XK_v:
-        case XK_V:
-            return Key::KEY_V;
-        case XK_w:
-        case XK_W:
-            return Key::KEY_W;
-        case XK_x:
-        case XK_X:
-            return Key::KEY_X;
-        case XK_y:
-        case XK_Y:
-            return Key::KEY_Y;
-        case XK_z:
-        case XK_Z:
-            return Key::KEY_Z;
-
-        case XK_1:
-            return Key::KEY__1;
-        case XK_2:
-            return Key::KEY__2;
-        case XK_3:
-            return Key::KEY__3;
-        case XK_4:
-            return Key::KEY__4;
-        case XK_5:
-            return Key::KEY__5;
-        case XK_6:
-            return Key::KEY__6;
-        case XK_7:
-            return Key::KEY__7;
-        case XK_8:
-            return Key::KEY__8;
-        case XK_9:
-            return Key::KEY__9;
-        case XK_0:
-            return Key::KEY__0;
-
-        case XK_Return:
-            return Key::KEY_RETURN;
-        case XK_Escape:
-            return Key::KEY_ESCAPE;
-        case XK_BackSpace:
-            return Key::KEY_BACKSPACE;
-        case XK_Tab:
-            return Key::KEY_TAB;
-        case XK_space:
-            return Key::KEY_SPACE;
-        case XK_minus:
-            return Key::KEY_MINUS;
-        case XK_equal:
-            return Key::KEY_EQUALS;
-        case XK_bracketleft:
-            return Key::KEY_LEFTBRACKET;
-        case XK_bracketright:
-            return Key::KEY_RIGHTBRACKET;
-        case XK_backslash:
-            return Key::KEY_BACKSLASH;
-        case XK_semicolon:
-            return Key::KEY_SEMICOLON;
-        case XK_apostrophe:
-            return Key::KEY_APOSTROPHE;
-        case XK_grave:
-            return Key::KEY_GRAVE;
-        case XK_comma:
-            return Key::KEY_COMMA;
-        case XK_period:
-            return Key::KEY_PERIOD;
-        case XK_slash:
-            return Key::KEY_SLASH;
-        case XK_Caps_Lock:
-            return Key::KEY_CAPSLOCK;
-
-        case XK_F1:
-            return Key::KEY_F1;
-        case XK_F2:
-            return Key::KEY_F2;
-        case XK_F3:
-            return Key::KEY_F3;
-        case XK_F4:
-            return Key::KEY_F4;
-        case XK_F5:
-            return Key::KEY_F5;
-        case XK_F6:
-            return Key::KEY_F6;
-        case XK_F7:
-            return Key::KEY_F7;
-        case XK_F8:
-            return Key::KEY_F8;
-        case XK_F9:
-            return Key::KEY_F9;
-        case XK_F10:
-            return Key::KEY_F10;
-        case XK_F11:
-            return Key::KEY_F11;
-        case XK_F12:
-            return Key::KEY_F12;
-
-        case XK_Print:
-            return Key::KEY_PRINTSCREEN;
-        case XK_Scroll_Lock:
-            return Key::KEY_SCROLLLOCK;
-        case XK_Pause:
-            return Key::KEY_PAUSE;
-        case XK_Insert:
-            return Key::KEY_INSERT;
-        case XK_Home:
-            return Key::KEY_HOME;
-        case XK_Page_Up:
-            return Key::KEY_PAGEUP;
-        case XK_Delete:
-            return Key::KEY_DELETE;
-        case XK_End:
-            return Key::KEY_END;
-        case XK_Page_Down:
-            return Key::KEY_PAGEDOWN;
-        case XK_Right:
-            return Key::KEY_RIGHT;
-        case XK_Left:
-            return Key::KEY_LEFT;
-        case XK_Down:
-            return Key::KEY_DOWN;
-        case XK_Up:
-            return Key::KEY_UP;
-
-        case XK_Num_Lock:
-            return Key::KEY_NUMLOCKCLEAR;
-        case XK_KP_Divide:
-            return Key::KEY_KP_DIVIDE;
-        case XK_KP_Multiply:
-            return Key::KEY_KP_MULTIPLY;
-        case XK_KP_Subtract:
-            return Key::KEY_KP_MINUS;
-        case XK_KP_Add:
-            return Key::KEY_KP_PLUS;
-        case XK_KP_Enter:
-            return Key::KEY_KP_ENTER;
-        case XK_KP_1:
-            return Key::KEY_KP_1;
-        case XK_KP_2:
-            return Key::KEY_KP_2;
-        case XK_KP_3:
-            return Key::KEY_KP_3;
-        case XK_KP_4:
-            return Key::KEY_KP_4;
-        case XK_KP_5:
-            return Key::KEY_KP_5;
-        case XK_KP_6:
-            return Key::KEY_KP_6;
-        case XK_KP_7:
-            return Key::KEY_KP_7;
-        case XK_KP_8:
-            return Key::KEY_KP_8;
-        case XK_KP_9:
-            return Key::KEY_KP_9;
-        case XK_KP_0:
-            return Key::KEY_KP_0;
-        case XK_KP_Decimal:
-            return Key::KEY_KP_PERIOD;
-
-        case XK_Control_L:
-            return Key::KEY_LCTRL;
-        case XK_Shift_L:
-            return Key::KEY_LSHIFT;
-        case XK_Alt_L:
-            return Key::KEY_LALT;
-        case XK_Super_L:
-            return Key::KEY_LGUI;
-        case XK_Control_R:
-            return Key::KEY_RCTRL;
-        case XK_Shift_R:
-            return Key::KEY_RSHIFT;
-        case XK_Alt_R:
-            return Key::KEY_RALT;
-        case XK_Super_R:
-            return Key::KEY_RGUI;
-
-        default:
-            return Key::KEY_UNKNOWN;
-        }
-    }
+#ifdef NOVA_WAYLAND_BACKEND
+#include <wayland-client.h>
+#include <wayland-egl.h>
+#include <Nova/Wayland.hpp>
+#endif
 
-    class PlatformData
-    {
-    public:
-        virtual ~PlatformData() = default;
-    };
-
-    class X11PlatformData : public PlatformData
-    {
-    public:
-        Display *display;
-        X11Window window;
-    };
+struct wl_display;
+struct wl_surface;
+struct xcb_connection_t;
 
+namespace Nova
+{
     enum class Backend
     {
         Wayland,
-        X11
-    };
-
-    enum class MouseButton
-    {
-        Left,
-        Right,
-        Middle
+        X11,
+        /// @brief X11 through xcb with pipelined requests, falls back to Xlib if Nova was built without xcb
+        Xcb,
+        Headless,
+        /// @brief Only valid as a request, resolved from NOVA_BACKEND (x11, xcb, wayland or headless) and defaulting to X11
+        Auto
     };
 
-    class Event
+    class X11Handles
     {
     public:
-        virtual ~Event() = default;
+        Display *display = nullptr;
+        X11Window window = 0;
     };
 
-    class MouseMoveEvent : public Event
+    class XcbHandles
     {
     public:
-        int x = 0;
-        int y = 0;
+        xcb_connection_t *connection = nullptr;
+        uint32_t window = 0;
     };
 
-    class MouseButtonDownEvent : public Event
+    class WaylandHandles
     {
     public:
-        MouseButton button;
+        wl_display *display = nullptr;
+        wl_surface *surface = nullptr;
     };
 
-    class MouseButtonUpEvent : public Event
+    class HeadlessHandles
     {
-    public:
-        MouseButton button;
     };
 
-    class KeyDownEvent : public Event
-    {
-    public:
-        Key key;
-        bool shift = false;
-    };
-
-    class KeyUpEvent : public Event
-    {
-    public:
-        Key key;
-        bool shift = false;
-    };
+    /// @brief Native handles of the active backend, e.g. std::get_if<Nova::X11Handles>(&handles)
+    using NativeHandles = std::variant<X11Handles, XcbHandles, WaylandHandles, HeadlessHandles>;
 
     class Window
     {
     private:
-        Display *display;
-        X11Window window;
-        int screen;
-        bool shift;
+        static constexpr size_t EventQueueCapacity = 1024;
+
+        // Backends are concrete classes, the active one is picked once in the constructor and every
+        // call dispatches through a single switch in VisitBackend, not per event
+        friend class X11Backend;
+        friend class XcbBackend;
+        friend class WaylandBackend;
+        friend class HeadlessBackend;
+        friend class GamepadManager;
+        friend class DisplayContext;
+
+        std::unique_ptr<X11Backend> x11;
+#ifdef NOVA_HAS_XCB
+        std::unique_ptr<XcbBackend> xcb;
+#endif
+#ifdef NOVA_WAYLAND_BACKEND
+        std::unique_ptr<WaylandBackend> wayland;
+#endif
+        std::unique_ptr<HeadlessBackend> headless;
+
+        template <typename Visitor>
+        decltype(auto) VisitBackend(Visitor &&visitor);
+
+        bool valid = true;
+
+        RingBuffer<Event> eventQueue;
+        size_t droppedEvents = 0;
+
+        MotionCoalescing motionCoalescing = MotionCoalescing::Disabled;
+        std::chrono::microseconds motionBucket{0};
+        bool canCoalesceMotion = false;
+        uint32_t motionBucketStart = 0;
+
+        bool motionBatching = false;
+        std::vector<MotionSample> motionSamples;
+
+        bool scrollAccumulation = true;
+        bool canCoalesceScroll = false;
+
+        // Handler registered with On<T>, type erased without std::function. invoke casts object or
+        // function back to what was registered.
+        class Listener
+        {
+        public:
+            void (*invoke)(const Listener &listener, const Event &event) = nullptr;
+            void *object = nullptr;
+            void (*function)() = nullptr;
+        };
+
+        // Indexed by Event::index(), so finding the listener for an event is one load
+        std::array<Listener, std::variant_size_v<Event>> listeners;
+
+        template <typename T, typename Handler>
+        static void InvokeObject(const Listener &listener, const Event &event)
+        {
+            (*static_cast<Handler *>(listener.object))(*std::get_if<T>(&event));
+        }
+
+        template <typename T>
+        static void InvokeFunction(const Listener &listener, const Event &event)
+        {
+            reinterpret_cast<void (*)(const T &)>(listener.function)(*std::get_if<T>(&event));
+        }
+
+        /// @brief Hands the event to its listener, or queues it if there is none. Returns true if the event was queued.
+        bool QueueEvent(const Event &event);
+        void QueueMotion(const MouseMoveEvent &motion);
+        void QueueScroll(const MouseScrollEvent &scroll);
+        void DispatchEvent(const Event &event);
+
+        // Updated as events enter the queue, so the input thread never touches them
+        KeyboardState keys;
+        KeyboardState keysPressed;
+        KeyboardState keysReleased;
+
+        // Latest size reported by the backend, turned into a WindowResizeEvent at the end of a poll
+        bool resizePending = false;
+        int pendingWidth = 0;
+        int pendingHeight = 0;
+        std::chrono::steady_clock::time_point lastResize;
+        std::chrono::milliseconds resizeDebounce{0};
+
+        void FlushResize();
+        std::chrono::nanoseconds ResizeSettleTime() const;
+
+        std::unique_ptr<ActionMap> actionMap;
+
+        // Created by the first EnableGamepads or OpenGamepad
+        std::unique_ptr<GamepadManager> gamepads;
+
+        GamepadManager *GetGamepads();
 
-        std::stack<Event *> eventStack;
+        // Queues an ActionEvent for every action the last input event changed
+        void QueueActionChanges(const EventBase &cause);
 
-        std::unordered_map<Key, bool> keyStates;
+        std::unique_ptr<InputRecorder> recorder;
+        std::unique_ptr<InputReplayer> replayer;
+        // Set while the backend polls during a replay, so live input doesn't mix with the log.
+        // Live resizes still get through.
+        bool liveInputMuted = false;
 
-        bool cursorLocked = false;
-        Cursor invisibleCursor;
+        void ReplayEvents();
 
+        // Set for the duration of PollEvents. Listeners run inside the gamepad and replay loops, so
+        // DisableGamepads and StopReplay only mark their subsystem and PollEvents destroys it at the end.
+        bool polling = false;
+        bool gamepadsClosing = false;
+        bool replayStopping = false;
+
+        void CloseGamepads();
+
+        /// @brief Time until Window has something to deliver without new input (a debounced resize
+        /// or a replayed event), nanoseconds::max() if nothing is pending
+        std::chrono::nanoseconds PendingDeadline() const;
+
+        // Instrumentation, only written when built with NOVA_INSTRUMENTATION
+        FrameStats frameStats;
+        bool latencyHistograms = false;
+        LatencyHistogram queueLatency;
+        LatencyHistogram deliveryLatency;
+
+        bool keyRepeatEvents = true;
+        Key repeatKey = Key::KEY_UNKNOWN;
+        int repeatCount = 0;
+
+        // eventfd written by PostEmptyEvent to wake WaitEvents from another thread
+        int wakeFd = -1;
+
+        void WaitForInput(const struct timespec *timeout);
+        bool HasPendingInput();
 
     public:
-        PlatformData *platformData;
         Backend backend;
 
         int width, height;
 
-        Window(std::string title, int width, int height);
+        /// @brief Creates the window on the requested backend. Wayland falls back to X11 if no
+        /// compositor is reachable. If no backend could be created the error is logged and IsValid
+        /// returns false, the window then behaves like a closed headless window.
+        Window(std::string title, int width, int height, Backend backend = Backend::Auto);
+
+        /// @brief Creates an X11 window on the connection of context, which reads the events of all
+        /// its windows in one place. Falls back like the constructor above if context has no display.
+        Window(DisplayContext &context, std::string title, int width, int height);
+        ~Window();
+
+        Window(const Window &) = delete;
+        Window &operator=(const Window &) = delete;
+
+        /// @brief False if the window could not be created, PollEvents then always returns false
+        bool IsValid() const;
+
+        /// @brief Handles of the backend the window was created on, for initializing a renderer
+        NativeHandles GetNativeHandles() const;
 
         bool PollEvents();
 
+        /// @brief Sleeps until input arrives or PostEmptyEvent is called, then polls. Returns false
+        /// when the window should close, like PollEvents.
+        bool WaitEvents();
+
+        /// @brief Like WaitEvents, but gives up waiting after timeout
+        bool WaitEventsTimeout(std::chrono::nanoseconds timeout);
+
+        /// @brief Wakes a thread blocked in WaitEvents, safe to call from any thread
+        void PostEmptyEvent();
+
         bool HasEvents();
 
-        Event *PopEvent();
+        /// @brief Whether auto-repeated presses are queued as KeyRepeatEvents, enabled by default.
+        /// Disabling drops them before they reach the queue.
+        void SetKeyRepeatEvents(bool enabled);
+
+        /// @brief True while the key is held, as of the last PollEvents
+        bool IsKeyDown(Key key) const;
+
+        /// @brief Copy of every held key as of the last PollEvents
+        KeyboardState GetKeyboardState() const;
+
+        /// @brief Keys that went down during the last PollEvents, including ones already released again
+        const KeyboardState &GetKeysPressed() const;
+
+        /// @brief Keys that went up during the last PollEvents
+        const KeyboardState &GetKeysReleased() const;
+
+        /// @brief Queues an event for the next PollEvents as if the backend had read it. Only supported
+        /// by the headless backend, returns false otherwise or if too many events are pending.
+        bool InjectEvent(const Event &event);
+
+        /// @brief Removes the oldest queued event and returns it by value, or nothing if the queue is
+        /// empty. Events are returned in the order the display server delivered them.
+        std::optional<Event> PopEvent();
+
+        /// @brief Calls handler(const T &) from inside PollEvents for every event of type T, instead of
+        /// queueing it for PopEvent. The handler is stored by address and has to outlive the
+        /// registration. Types without a listener are still queued, so both styles can be mixed.
+        /// DisableGamepads and StopReplay may be called from a handler, they take effect when
+        /// PollEvents returns and no further gamepad or replayed events are delivered meanwhile.
+        template <typename T, typename Handler>
+        void On(Handler &handler)
+        {
+            Listener &listener = listeners[EventIndex<T>()];
+            listener.invoke = &InvokeObject<T, Handler>;
+            listener.object = &handler;
+            listener.function = nullptr;
+        }
+
+        /// @brief Like On(Handler &) for a plain function or a lambda without captures
+        template <typename T>
+        void On(void (*handler)(const T &))
+        {
+            Listener &listener = listeners[EventIndex<T>()];
+            listener.invoke = &InvokeFunction<T>;
+            listener.object = nullptr;
+            listener.function = reinterpret_cast<void (*)()>(handler);
+        }
+
+        /// @brief Removes the listener for T, its events are queued again
+        template <typename T>
+        void Off()
+        {
+            listeners[EventIndex<T>()] = Listener();
+        }
 
         void LockCursor();
         void UnlockCursor();
+
+        /// @brief Read gamepads and joysticks from the evdev nodes in directory, and pick up pads that
+        /// are plugged in later. Needs read access to the nodes, usually through a udev uaccess rule.
+        /// Pads found here or opened with OpenGamepad are announced by the next PollEvents.
+        bool EnableGamepads(const std::string &directory = "/dev/input");
+
+        /// @brief Closes every gamepad and stops watching for new ones. The next PollEvents delivers a
+        /// GamepadDisconnectedEvent for each pad that was open, or the current one if called from a listener.
+        void DisableGamepads();
+
+        /// @brief Opens an evdev node, a FIFO or a file of recorded struct input_event records as a
+        /// gamepad, e.g. to test without hardware. A file is played back a batch per PollEvents.
+        /// Returns the gamepad slot or -1.
+        int OpenGamepad(const std::string &path);
+
+        /// @brief Axis values below deadzone (0 to 0.99, default 0.15) read as 0
+        void SetGamepadDeadzone(float deadzone);
+
+        bool IsGamepadConnected(int gamepad) const;
+        const char *GetGamepadName(int gamepad) const;
+
+        /// @brief Resolve input through map from now on, compiling it if needed. Changes are queued as
+        /// ActionEvents after the input event that caused them, and the per frame state below is
+        /// updated by every PollEvents.
+        void SetActionMap(ActionMap map);
+        void ClearActionMap();
+
+        /// @brief True while any binding of the action is held, as of the last PollEvents
+        bool IsActionDown(ActionId action) const;
+
+        /// @brief Actions that went down or up during the last PollEvents
+        bool WasActionPressed(ActionId action) const;
+        bool WasActionReleased(ActionId action) const;
+
+        /// @brief -1 to 1 for axes, 0 or the binding value otherwise
+        float GetActionValue(ActionId action) const;
+
+        /// @brief Append every event the backend delivers to a memory-mapped log at path
+        bool StartRecording(const std::string &path);
+        void StopRecording();
+
+        /// @brief Deliver the events of a log written by StartRecording through PollEvents/PopEvent
+        /// instead of live input, until the log ends or StopReplay is called. Recorded resizes are
+        /// skipped, resizes of the real window are still delivered.
+        bool StartReplay(const std::string &path, ReplaySpeed speed = ReplaySpeed::Original);
+        void StopReplay();
+        bool IsReplaying() const;
+
+        /// @brief Counters of the last PollEvents call, all zero unless Nova was built with NOVA_INSTRUMENTATION
+        const FrameStats &GetFrameStats() const;
+
+        /// @brief Record per event latency histograms. Off by default, PopEvent then reads the clock once per event.
+        void SetLatencyHistograms(bool enabled);
+
+        /// @brief Time between Nova reading an event from the connection and PopEvent returning it, or
+        /// its listener being called
+        const LatencyHistogram &GetQueueLatency() const;
+
+        /// @brief Time between the server timestamp and Nova reading the event, at millisecond
+        /// resolution. Assumes the server clock is CLOCK_MONOTONIC, as with Xorg and Wayland compositors.
+        const LatencyHistogram &GetDeliveryLatency() const;
+
+        void ResetLatencyHistograms();
+
+        /// @brief Allow the user to resize the window. width and height follow WindowResizeEvents.
+        void SetResizable(bool resizable);
+
+        /// @brief Hold back WindowResizeEvent until the size has not changed for debounce, so a drag
+        /// produces one event once it settles. WaitEvents wakes up by itself to deliver it.
+        void SetResizeDebounce(std::chrono::milliseconds debounce);
+
+        /// @brief Buffer to draw the next frame into on the CPU, created on first use. Uses MIT-SHM
+        /// double buffering on X11 and falls back to XPutImage when SHM is unavailable. Waits if the
+        /// server is still reading this buffer from an earlier Present. Pixels is null if the
+        /// backend has no software surface.
+        SoftwareSurface GetSoftwareSurface();
+
+        /// @brief Shows the buffer returned by the last GetSoftwareSurface
+        void Present();
+
+        /// @brief Moves input handling to a dedicated thread with its own X connection. Input is then
+        /// read and timestamped as soon as it arrives, independent of frame time, and PopEvent drains
+        /// what the thread produced. Returns false if the thread could not be started or the window
+        /// is not on X11.
+        bool StartInputThread();
+        void StopInputThread();
+
+        /// @brief Merge consecutive motion events. Absolute motion keeps the latest position, relative
+        /// motion sums the deltas. Bucket is compared against server timestamps, which have millisecond
+        /// resolution.
+        void SetMotionCoalescing(MotionCoalescing mode, std::chrono::microseconds bucket = std::chrono::microseconds(0));
+
+        /// @brief Record every raw motion sample of a poll, independent of coalescing
+        void SetMotionBatching(bool enabled);
+
+        /// @brief Merge consecutive MouseScrollEvents of one PollEvents call into one by summing their
+        /// deltas, so a touchpad flick is one event per frame. Enabled by default.
+        void SetScrollAccumulation(bool enabled);
+
+        /// @brief All motion samples read by the last PollEvents call, in order. Empty unless batching is enabled.
+        const std::vector<MotionSample> &GetMotionSamples() const;
     };
 }
\ No newline at end of file
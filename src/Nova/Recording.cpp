@@ -0,0 +1,295 @@
+#include <Nova/Recording.hpp>
+#include <Flux/Flux.hpp>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+namespace Nova
+{
+    static constexpr char LogMagic[8] = { 'N', 'O', 'V', 'A', 'R', 'E', 'C', '1' };
+    static constexpr size_t MinimumLogCapacity = 1 << 20;
+
+    class LogHeader
+    {
+    public:
+        char magic[8];
+        /// @brief Rejects logs recorded by a build with a different set of events
+        uint32_t eventTypes;
+        uint32_t reserved;
+    };
+
+    class RecordHeader
+    {
+    public:
+        uint16_t type;
+        uint16_t size;
+        uint32_t reserved;
+        /// @brief hostTime relative to the start of the recording
+        int64_t offset;
+    };
+
+    // Events are written as raw bytes, which only works while they stay plain data
+    template <size_t... I>
+    static constexpr bool AllTriviallyCopyable(std::index_sequence<I...>)
+    {
+        return (std::is_trivially_copyable_v<std::variant_alternative_t<I, Event>> && ...);
+    }
+    static_assert(AllTriviallyCopyable(std::make_index_sequence<std::variant_size_v<Event>>()),
+                  "Recorded events must be trivially copyable");
+
+    template <size_t I>
+    static bool DecodeAlternative(const uint8_t *payload, size_t size, Event &out)
+    {
+        using T = std::variant_alternative_t<I, Event>;
+        if (size != sizeof(T))
+        {
+            return false;
+        }
+
+        T value;
+        memcpy(&value, payload, sizeof(T));
+        out = value;
+        return true;
+    }
+
+    template <size_t... I>
+    static bool DecodeEvent(size_t type, const uint8_t *payload, size_t size, Event &out, std::index_sequence<I...>)
+    {
+        return ((type == I && DecodeAlternative<I>(payload, size, out)) || ...);
+    }
+
+    InputRecorder::~InputRecorder()
+    {
+        Close();
+    }
+
+    bool InputRecorder::Open(const std::string &path)
+    {
+        Close();
+
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd == -1)
+        {
+            Flux::Error("Unable to create input log {}", path);
+            return false;
+        }
+
+        size = 0;
+        if (!Reserve(sizeof(LogHeader)))
+        {
+            Close();
+            return false;
+        }
+
+        LogHeader header = {};
+        memcpy(header.magic, LogMagic, sizeof(LogMagic));
+        header.eventTypes = std::variant_size_v<Event>;
+        memcpy(mapping, &header, sizeof(header));
+        size = sizeof(header);
+
+        start = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    bool InputRecorder::Reserve(size_t needed)
+    {
+        if (needed <= capacity)
+        {
+            return true;
+        }
+
+        // Grow geometrically so remapping stays rare
+        size_t newCapacity = capacity * 2 > MinimumLogCapacity ? capacity * 2 : MinimumLogCapacity;
+        while (newCapacity < needed)
+        {
+            newCapacity *= 2;
+        }
+
+        if (ftruncate(fd, newCapacity) != 0)
+        {
+            Flux::Error("Unable to grow input log");
+            return false;
+        }
+
+        void *grown = mapping == nullptr
+                          ? mmap(nullptr, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                          : mremap(mapping, capacity, newCapacity, MREMAP_MAYMOVE);
+        if (grown == MAP_FAILED)
+        {
+            Flux::Error("Unable to map input log");
+            return false;
+        }
+
+        mapping = static_cast<uint8_t *>(grown);
+        capacity = newCapacity;
+        return true;
+    }
+
+    void InputRecorder::Record(const Event &event)
+    {
+        if (mapping == nullptr)
+        {
+            return;
+        }
+
+        std::visit([&](const auto &value) {
+            RecordHeader header = {};
+            header.type = static_cast<uint16_t>(event.index());
+            header.size = static_cast<uint16_t>(sizeof(value));
+            header.offset = std::chrono::duration_cast<std::chrono::nanoseconds>(value.hostTime - start).count();
+
+            if (!Reserve(size + sizeof(header) + sizeof(value)))
+            {
+                return;
+            }
+
+            memcpy(mapping + size, &header, sizeof(header));
+            memcpy(mapping + size + sizeof(header), &value, sizeof(value));
+            size += sizeof(header) + sizeof(value);
+        }, event);
+    }
+
+    void InputRecorder::Close()
+    {
+        if (mapping != nullptr)
+        {
+            munmap(mapping, capacity);
+            mapping = nullptr;
+        }
+
+        if (fd != -1)
+        {
+            // Drop the unused tail of the last growth step
+            if (ftruncate(fd, size) != 0)
+            {
+                Flux::Error("Unable to trim input log");
+            }
+            close(fd);
+            fd = -1;
+        }
+
+        capacity = 0;
+        size = 0;
+    }
+
+    InputReplayer::~InputReplayer()
+    {
+        Close();
+    }
+
+    bool InputReplayer::Open(const std::string &path, ReplaySpeed speed)
+    {
+        Close();
+
+        fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            Flux::Error("Unable to open input log {}", path);
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(LogHeader))
+        {
+            Flux::Error("{} is not a Nova input log", path);
+            Close();
+            return false;
+        }
+
+        size = info.st_size;
+        void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            Flux::Error("Unable to map input log {}", path);
+            mapping = nullptr;
+            Close();
+            return false;
+        }
+        mapping = static_cast<const uint8_t *>(mapped);
+
+        LogHeader header;
+        memcpy(&header, mapping, sizeof(header));
+        if (memcmp(header.magic, LogMagic, sizeof(LogMagic)) != 0 || header.eventTypes != std::variant_size_v<Event>)
+        {
+            Flux::Error("{} is not a Nova input log of this version", path);
+            Close();
+            return false;
+        }
+
+        offset = sizeof(LogHeader);
+        this->speed = speed;
+        start = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    std::chrono::nanoseconds InputReplayer::NextOffset() const
+    {
+        RecordHeader header;
+        memcpy(&header, mapping + offset, sizeof(header));
+        return std::chrono::nanoseconds(header.offset);
+    }
+
+    bool InputReplayer::Next(Event &out, std::chrono::steady_clock::time_point now)
+    {
+        if (offset + sizeof(RecordHeader) > size)
+        {
+            offset = size;
+            return false;
+        }
+
+        if (speed == ReplaySpeed::Original && now - start < NextOffset())
+        {
+            return false;
+        }
+
+        RecordHeader header;
+        memcpy(&header, mapping + offset, sizeof(header));
+        const uint8_t *payload = mapping + offset + sizeof(header);
+
+        if (offset + sizeof(header) + header.size > size ||
+            !DecodeEvent(header.type, payload, header.size, out, std::make_index_sequence<std::variant_size_v<Event>>()))
+        {
+            Flux::Error("Input log is truncated or corrupt, stopping replay");
+            offset = size;
+            return false;
+        }
+
+        offset += sizeof(header) + header.size;
+
+        // Replayed events are read now, so queue latency stays meaningful
+        std::visit([&](auto &value) { value.hostTime = now; }, out);
+        return true;
+    }
+
+    std::chrono::nanoseconds InputReplayer::TimeUntilNext(std::chrono::steady_clock::time_point now) const
+    {
+        if (speed == ReplaySpeed::Fast || offset + sizeof(RecordHeader) > size)
+        {
+            return std::chrono::nanoseconds::zero();
+        }
+
+        return NextOffset() - (now - start);
+    }
+
+    void InputReplayer::Close()
+    {
+        if (mapping != nullptr)
+        {
+            munmap(const_cast<uint8_t *>(mapping), size);
+            mapping = nullptr;
+        }
+
+        if (fd != -1)
+        {
+            close(fd);
+            fd = -1;
+        }
+
+        size = 0;
+        offset = 0;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <Nova/Event.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Nova
+{
+    enum class ReplaySpeed
+    {
+        /// @brief Events are delivered at the times they were recorded at
+        Original,
+        /// @brief Every poll delivers as many events as fit in the queue, listeners or not
+        Fast
+    };
+
+    /// @brief Appends translated events to a memory-mapped log file. Each record is a small header
+    /// followed by the raw event, so recording is two memcpys.
+    class InputRecorder
+    {
+    private:
+        int fd = -1;
+        uint8_t *mapping = nullptr;
+        size_t capacity = 0;
+        size_t size = 0;
+        std::chrono::steady_clock::time_point start;
+
+        bool Reserve(size_t needed);
+
+    public:
+        InputRecorder() = default;
+        ~InputRecorder();
+
+        InputRecorder(const InputRecorder &) = delete;
+        InputRecorder &operator=(const InputRecorder &) = delete;
+
+        /// @brief Creates or truncates the log, returns false if it could not be created
+        bool Open(const std::string &path);
+
+        void Record(const Event &event);
+
+        /// @brief Trims the file to the recorded size and unmaps it
+        void Close();
+    };
+
+    /// @brief Reads a log written by InputRecorder back, in order
+    class InputReplayer
+    {
+    private:
+        int fd = -1;
+        const uint8_t *mapping = nullptr;
+        size_t size = 0;
+        size_t offset = 0;
+        ReplaySpeed speed = ReplaySpeed::Original;
+        std::chrono::steady_clock::time_point start;
+
+        std::chrono::nanoseconds NextOffset() const;
+
+    public:
+        InputReplayer() = default;
+        ~InputReplayer();
+
+        InputReplayer(const InputReplayer &) = delete;
+        InputReplayer &operator=(const InputReplayer &) = delete;
+
+        /// @brief Maps the log and starts its clock, returns false if it is missing or not a Nova log
+        bool Open(const std::string &path, ReplaySpeed speed);
+
+        /// @brief Reads the next event if it is due at now, with hostTime set to now
+        bool Next(Event &out, std::chrono::steady_clock::time_point now);
+
+        bool Finished() const { return offset >= size; }
+
+        /// @brief Time until the next event is due, zero at fast speed
+        std::chrono::nanoseconds TimeUntilNext(std::chrono::steady_clock::time_point now) const;
+
+        void Close();
+    };
+}
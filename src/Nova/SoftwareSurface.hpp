@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+
+namespace Nova
+{
+    /// @brief CPU writable pixels of a window, 32 bits per pixel as 0x00RRGGBB
+    class SoftwareSurface
+    {
+    public:
+        uint32_t *pixels = nullptr;
+        int width = 0;
+        int height = 0;
+        /// @brief Distance between rows in pixels, can be larger than width
+        int stride = 0;
+    };
+}
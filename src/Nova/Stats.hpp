@@ -0,0 +1,114 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Nova
+{
+    /// @brief Log-linear latency histogram in the spirit of HdrHistogram. Every power of two is
+    /// split into 8 linear buckets, so recording is a count-leading-zeros and an increment and the
+    /// relative error stays below 12.5% from nanoseconds up to minutes.
+    class LatencyHistogram
+    {
+    public:
+        static constexpr int SubBucketBits = 3;
+        static constexpr int SubBuckets = 1 << SubBucketBits;
+        static constexpr int BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+    private:
+        uint64_t counts[BucketCount] = {};
+        uint64_t total = 0;
+        uint64_t maximum = 0;
+
+        static int BucketIndex(uint64_t value)
+        {
+            if (value < SubBuckets)
+            {
+                return static_cast<int>(value);
+            }
+
+            int exponent = 63 - __builtin_clzll(value);
+            int subBucket = static_cast<int>((value >> (exponent - SubBucketBits)) & (SubBuckets - 1));
+            return (exponent - SubBucketBits + 1) * SubBuckets + subBucket;
+        }
+
+        static uint64_t BucketUpperBound(int index)
+        {
+            if (index < SubBuckets)
+            {
+                return static_cast<uint64_t>(index);
+            }
+
+            int exponent = index / SubBuckets + SubBucketBits - 1;
+            uint64_t subBucket = static_cast<uint64_t>(index % SubBuckets);
+            uint64_t lower = (uint64_t(1) << exponent) | (subBucket << (exponent - SubBucketBits));
+            return lower + (uint64_t(1) << (exponent - SubBucketBits)) - 1;
+        }
+
+    public:
+        void Record(std::chrono::nanoseconds latency)
+        {
+            uint64_t value = latency.count() > 0 ? static_cast<uint64_t>(latency.count()) : 0;
+            counts[BucketIndex(value)]++;
+            total++;
+            if (value > maximum)
+            {
+                maximum = value;
+            }
+        }
+
+        uint64_t Count() const { return total; }
+        std::chrono::nanoseconds Max() const { return std::chrono::nanoseconds(maximum); }
+
+        /// @brief Smallest latency that at least percentile (0 to 100) of the samples do not exceed,
+        /// rounded up to the bucket bound
+        std::chrono::nanoseconds Percentile(double percentile) const
+        {
+            if (total == 0)
+            {
+                return std::chrono::nanoseconds::zero();
+            }
+
+            uint64_t target = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5);
+            if (target == 0)
+            {
+                target = 1;
+            }
+
+            uint64_t seen = 0;
+            for (int i = 0; i < BucketCount; i++)
+            {
+                seen += counts[i];
+                if (seen >= target)
+                {
+                    uint64_t bound = BucketUpperBound(i);
+                    return std::chrono::nanoseconds(bound < maximum ? bound : maximum);
+                }
+            }
+            return Max();
+        }
+
+        void Reset()
+        {
+            for (int i = 0; i < BucketCount; i++)
+            {
+                counts[i] = 0;
+            }
+            total = 0;
+            maximum = 0;
+        }
+    };
+
+    /// @brief What the last PollEvents call did
+    class FrameStats
+    {
+    public:
+        /// @brief Events the backend delivered, before coalescing
+        size_t eventsProcessed = 0;
+        /// @brief Motion events merged into an already queued event
+        size_t eventsCoalesced = 0;
+        /// @brief Events lost because the queue was full
+        size_t eventsDropped = 0;
+        std::chrono::nanoseconds pollDuration{0};
+    };
+}
@@ -0,0 +1,995 @@
+#ifdef NOVA_WAYLAND_BACKEND
+#include <Nova/Nova.hpp>
+#include <Nova/Wayland.hpp>
+#include <Flux/Flux.hpp>
+#include <xdg-shell-client-protocol.h>
+#include <relative-pointer-unstable-v1-client-protocol.h>
+#include <pointer-constraints-unstable-v1-client-protocol.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+
+namespace Nova
+{
+    // Linux evdev button codes from linux/input-event-codes.h, which can't be included here because
+    // its KEY_* macros collide with Nova::Key
+    static constexpr uint32_t EvdevButtonLeft = 0x110;
+    static constexpr uint32_t EvdevButtonRight = 0x111;
+    static constexpr uint32_t EvdevButtonMiddle = 0x112;
+    static constexpr uint32_t EvdevButtonSide = 0x113;
+    static constexpr uint32_t EvdevButtonExtra = 0x114;
+
+    // Without the keymap, the keys xkb marks as not repeating are recognised by position
+    static bool KeyRepeats(Key key)
+    {
+        switch (key)
+        {
+        case Key::KEY_LSHIFT:
+        case Key::KEY_RSHIFT:
+        case Key::KEY_LCTRL:
+        case Key::KEY_RCTRL:
+        case Key::KEY_LALT:
+        case Key::KEY_RALT:
+        case Key::KEY_LGUI:
+        case Key::KEY_RGUI:
+        case Key::KEY_CAPSLOCK:
+        case Key::KEY_NUMLOCKCLEAR:
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    // Repeats delivered by one poll at most, a stalled application doesn't get a burst of them
+    static constexpr int MaxRepeatsPerPoll = 4;
+
+    // wl_pointer.axis reports surface coordinates, about 10 per wheel click on most compositors. Only
+    // used for sources without axis_discrete.
+    static constexpr double AxisUnitsPerDetent = 10.0;
+
+    // wl_keyboard reports evdev keycodes, which are positional just like Nova::Key
+    static const std::array<Key, 256> evdevKeyTable = []
+    {
+        std::array<Key, 256> table{};
+        table.fill(Key::KEY_UNKNOWN);
+
+        table[1] = Key::KEY_ESCAPE;
+        table[2] = Key::KEY__1;
+        table[3] = Key::KEY__2;
+        table[4] = Key::KEY__3;
+        table[5] = Key::KEY__4;
+        table[6] = Key::KEY__5;
+        table[7] = Key::KEY__6;
+        table[8] = Key::KEY__7;
+        table[9] = Key::KEY__8;
+        table[10] = Key::KEY__9;
+        table[11] = Key::KEY__0;
+        table[12] = Key::KEY_MINUS;
+        table[13] = Key::KEY_EQUALS;
+        table[14] = Key::KEY_BACKSPACE;
+        table[15] = Key::KEY_TAB;
+        table[16] = Key::KEY_Q;
+        table[17] = Key::KEY_W;
+        table[18] = Key::KEY_E;
+        table[19] = Key::KEY_R;
+        table[20] = Key::KEY_T;
+        table[21] = Key::KEY_Y;
+        table[22] = Key::KEY_U;
+        table[23] = Key::KEY_I;
+        table[24] = Key::KEY_O;
+        table[25] = Key::KEY_P;
+        table[26] = Key::KEY_LEFTBRACKET;
+        table[27] = Key::KEY_RIGHTBRACKET;
+        table[28] = Key::KEY_RETURN;
+        table[29] = Key::KEY_LCTRL;
+        table[30] = Key::KEY_A;
+        table[31] = Key::KEY_S;
+        table[32] = Key::KEY_D;
+        table[33] = Key::KEY_F;
+        table[34] = Key::KEY_G;
+        table[35] = Key::KEY_H;
+        table[36] = Key::KEY_J;
+        table[37] = Key::KEY_K;
+        table[38] = Key::KEY_L;
+        table[39] = Key::KEY_SEMICOLON;
+        table[40] = Key::KEY_APOSTROPHE;
+        table[41] = Key::KEY_GRAVE;
+        table[42] = Key::KEY_LSHIFT;
+        table[43] = Key::KEY_BACKSLASH;
+        table[44] = Key::KEY_Z;
+        table[45] = Key::KEY_X;
+        table[46] = Key::KEY_C;
+        table[47] = Key::KEY_V;
+        table[48] = Key::KEY_B;
+        table[49] = Key::KEY_N;
+        table[50] = Key::KEY_M;
+        table[51] = Key::KEY_COMMA;
+        table[52] = Key::KEY_PERIOD;
+        table[53] = Key::KEY_SLASH;
+        table[54] = Key::KEY_RSHIFT;
+        table[55] = Key::KEY_KP_MULTIPLY;
+        table[56] = Key::KEY_LALT;
+        table[57] = Key::KEY_SPACE;
+        table[58] = Key::KEY_CAPSLOCK;
+        table[59] = Key::KEY_F1;
+        table[60] = Key::KEY_F2;
+        table[61] = Key::KEY_F3;
+        table[62] = Key::KEY_F4;
+        table[63] = Key::KEY_F5;
+        table[64] = Key::KEY_F6;
+        table[65] = Key::KEY_F7;
+        table[66] = Key::KEY_F8;
+        table[67] = Key::KEY_F9;
+        table[68] = Key::KEY_F10;
+        table[69] = Key::KEY_NUMLOCKCLEAR;
+        table[70] = Key::KEY_SCROLLLOCK;
+        table[71] = Key::KEY_KP_7;
+        table[72] = Key::KEY_KP_8;
+        table[73] = Key::KEY_KP_9;
+        table[74] = Key::KEY_KP_MINUS;
+        table[75] = Key::KEY_KP_4;
+        table[76] = Key::KEY_KP_5;
+        table[77] = Key::KEY_KP_6;
+        table[78] = Key::KEY_KP_PLUS;
+        table[79] = Key::KEY_KP_1;
+        table[80] = Key::KEY_KP_2;
+        table[81] = Key::KEY_KP_3;
+        table[82] = Key::KEY_KP_0;
+        table[83] = Key::KEY_KP_PERIOD;
+        table[86] = Key::KEY_NONUSBACKSLASH;
+        table[87] = Key::KEY_F11;
+        table[88] = Key::KEY_F12;
+        table[96] = Key::KEY_KP_ENTER;
+        table[97] = Key::KEY_RCTRL;
+        table[98] = Key::KEY_KP_DIVIDE;
+        table[99] = Key::KEY_PRINTSCREEN;
+        table[100] = Key::KEY_RALT;
+        table[102] = Key::KEY_HOME;
+        table[103] = Key::KEY_UP;
+        table[104] = Key::KEY_PAGEUP;
+        table[105] = Key::KEY_LEFT;
+        table[106] = Key::KEY_RIGHT;
+        table[107] = Key::KEY_END;
+        table[108] = Key::KEY_DOWN;
+        table[109] = Key::KEY_PAGEDOWN;
+        table[110] = Key::KEY_INSERT;
+        table[111] = Key::KEY_DELETE;
+        table[113] = Key::KEY_MUTE;
+        table[114] = Key::KEY_VOLUMEDOWN;
+        table[115] = Key::KEY_VOLUMEUP;
+        table[116] = Key::KEY_POWER;
+        table[117] = Key::KEY_KP_EQUALS;
+        table[119] = Key::KEY_PAUSE;
+        table[121] = Key::KEY_KP_COMMA;
+        table[125] = Key::KEY_LGUI;
+        table[126] = Key::KEY_RGUI;
+        table[127] = Key::KEY_APPLICATION;
+        table[128] = Key::KEY_STOP;
+        table[129] = Key::KEY_AGAIN;
+        table[131] = Key::KEY_UNDO;
+        table[133] = Key::KEY_COPY;
+        table[135] = Key::KEY_PASTE;
+        table[136] = Key::KEY_FIND;
+        table[137] = Key::KEY_CUT;
+        table[138] = Key::KEY_HELP;
+        table[139] = Key::KEY_MENU;
+        table[140] = Key::KEY_CALCULATOR;
+        table[142] = Key::KEY_SLEEP;
+        table[150] = Key::KEY_WWW;
+        table[155] = Key::KEY_MAIL;
+        table[156] = Key::KEY_AC_BOOKMARKS;
+        table[157] = Key::KEY_COMPUTER;
+        table[158] = Key::KEY_AC_BACK;
+        table[159] = Key::KEY_AC_FORWARD;
+        table[161] = Key::KEY_EJECT;
+        table[163] = Key::KEY_AUDIONEXT;
+        table[164] = Key::KEY_AUDIOPLAY;
+        table[165] = Key::KEY_AUDIOPREV;
+        table[166] = Key::KEY_AUDIOSTOP;
+        table[172] = Key::KEY_AC_HOME;
+        table[173] = Key::KEY_AC_REFRESH;
+        table[183] = Key::KEY_F13;
+        table[184] = Key::KEY_F14;
+        table[185] = Key::KEY_F15;
+        table[186] = Key::KEY_F16;
+        table[187] = Key::KEY_F17;
+        table[188] = Key::KEY_F18;
+        table[189] = Key::KEY_F19;
+        table[190] = Key::KEY_F20;
+        table[191] = Key::KEY_F21;
+        table[192] = Key::KEY_F22;
+        table[193] = Key::KEY_F23;
+        table[194] = Key::KEY_F24;
+        table[217] = Key::KEY_AC_SEARCH;
+        table[224] = Key::KEY_BRIGHTNESSDOWN;
+        table[225] = Key::KEY_BRIGHTNESSUP;
+        table[226] = Key::KEY_MEDIASELECT;
+        table[228] = Key::KEY_KBDILLUMTOGGLE;
+        table[229] = Key::KEY_KBDILLUMDOWN;
+        table[230] = Key::KEY_KBDILLUMUP;
+
+        return table;
+    }();
+
+    static Key EvdevKeyToNovaKey(uint32_t code)
+    {
+        return code < evdevKeyTable.size() ? evdevKeyTable[code] : Key::KEY_UNKNOWN;
+    }
+
+    // Listeners are value-initialized and filled by name, so members that newer protocol headers
+    // add stay null instead of tripping -Wmissing-field-initializers. Events for them are never
+    // sent, every global is bound at a version that predates them.
+    const xdg_wm_base_listener WaylandBackend::wmBaseListener = []
+    {
+        xdg_wm_base_listener listener{};
+        listener.ping = WaylandBackend::HandleWmBasePing;
+        return listener;
+    }();
+
+    const xdg_surface_listener WaylandBackend::surfaceListener = []
+    {
+        xdg_surface_listener listener{};
+        listener.configure = WaylandBackend::HandleSurfaceConfigure;
+        return listener;
+    }();
+
+    const xdg_toplevel_listener WaylandBackend::toplevelListener = []
+    {
+        xdg_toplevel_listener listener{};
+        listener.configure = WaylandBackend::HandleToplevelConfigure;
+        listener.close = WaylandBackend::HandleToplevelClose;
+        return listener;
+    }();
+
+    const zwp_relative_pointer_v1_listener WaylandBackend::relativePointerListener = []
+    {
+        zwp_relative_pointer_v1_listener listener{};
+        listener.relative_motion = WaylandBackend::HandleRelativeMotion;
+        return listener;
+    }();
+
+    const wl_registry_listener WaylandBackend::registryListener = []
+    {
+        wl_registry_listener listener{};
+        listener.global = WaylandBackend::HandleGlobal;
+        listener.global_remove = WaylandBackend::HandleGlobalRemove;
+        return listener;
+    }();
+
+    const wl_seat_listener WaylandBackend::seatListener = []
+    {
+        wl_seat_listener listener{};
+        listener.capabilities = WaylandBackend::HandleSeatCapabilities;
+        listener.name = WaylandBackend::HandleSeatName;
+        return listener;
+    }();
+
+    const wl_keyboard_listener WaylandBackend::keyboardListener = []
+    {
+        wl_keyboard_listener listener{};
+        listener.keymap = WaylandBackend::HandleKeymap;
+        listener.enter = WaylandBackend::HandleKeyboardEnter;
+        listener.leave = WaylandBackend::HandleKeyboardLeave;
+        listener.key = WaylandBackend::HandleKey;
+        listener.modifiers = WaylandBackend::HandleModifiers;
+        listener.repeat_info = WaylandBackend::HandleRepeatInfo;
+        return listener;
+    }();
+
+    const wl_pointer_listener WaylandBackend::pointerListener = []
+    {
+        wl_pointer_listener listener{};
+        listener.enter = WaylandBackend::HandlePointerEnter;
+        listener.leave = WaylandBackend::HandlePointerLeave;
+        listener.motion = WaylandBackend::HandlePointerMotion;
+        listener.button = WaylandBackend::HandlePointerButton;
+        listener.axis = WaylandBackend::HandlePointerAxis;
+        listener.frame = WaylandBackend::HandlePointerFrame;
+        listener.axis_source = WaylandBackend::HandlePointerAxisSource;
+        listener.axis_stop = WaylandBackend::HandlePointerAxisStop;
+        listener.axis_discrete = WaylandBackend::HandlePointerAxisDiscrete;
+        return listener;
+    }();
+
+    WaylandBackend::WaylandBackend(Window &owner)
+        : owner(owner)
+    {
+    }
+
+    WaylandBackend::~WaylandBackend()
+    {
+        if (display == nullptr)
+        {
+            return;
+        }
+
+        UnlockCursor();
+
+        if (relativePointer != nullptr)
+            zwp_relative_pointer_v1_destroy(relativePointer);
+        if (relativePointerManager != nullptr)
+            zwp_relative_pointer_manager_v1_destroy(relativePointerManager);
+        if (pointerConstraints != nullptr)
+            zwp_pointer_constraints_v1_destroy(pointerConstraints);
+        if (cursorSurface != nullptr)
+            wl_surface_destroy(cursorSurface);
+        if (cursorTheme != nullptr)
+            wl_cursor_theme_destroy(cursorTheme);
+        if (toplevel != nullptr)
+            xdg_toplevel_destroy(toplevel);
+        if (xdgSurface != nullptr)
+            xdg_surface_destroy(xdgSurface);
+        if (surface != nullptr)
+            wl_surface_destroy(surface);
+        if (pointer != nullptr)
+            wl_pointer_destroy(pointer);
+        if (keyboard != nullptr)
+            wl_keyboard_destroy(keyboard);
+        if (seat != nullptr)
+            wl_seat_destroy(seat);
+        if (wmBase != nullptr)
+            xdg_wm_base_destroy(wmBase);
+        if (shm != nullptr)
+            wl_shm_destroy(shm);
+        if (compositor != nullptr)
+            wl_compositor_destroy(compositor);
+        if (registry != nullptr)
+            wl_registry_destroy(registry);
+
+        wl_display_disconnect(display);
+    }
+
+    bool WaylandBackend::Create(const std::string &title, int width, int height)
+    {
+        display = wl_display_connect(nullptr);
+        if (display == nullptr)
+        {
+            return false;
+        }
+
+        registry = wl_display_get_registry(display);
+        wl_registry_add_listener(registry, &registryListener, this);
+
+        // First roundtrip delivers the globals, the second the seat capabilities they trigger
+        wl_display_roundtrip(display);
+        wl_display_roundtrip(display);
+
+        if (compositor == nullptr || wmBase == nullptr)
+        {
+            Flux::Error("Wayland compositor does not support xdg-shell");
+            return false;
+        }
+
+        surface = wl_compositor_create_surface(compositor);
+
+        // Clients draw their own cursor on Wayland, so LockCursor has something to restore
+        if (shm != nullptr)
+        {
+            cursorTheme = wl_cursor_theme_load(nullptr, 24, shm);
+            if (cursorTheme != nullptr)
+            {
+                defaultCursor = wl_cursor_theme_get_cursor(cursorTheme, "left_ptr");
+                cursorSurface = wl_compositor_create_surface(compositor);
+            }
+        }
+
+        xdgSurface = xdg_wm_base_get_xdg_surface(wmBase, surface);
+        xdg_surface_add_listener(xdgSurface, &surfaceListener, this);
+
+        toplevel = xdg_surface_get_toplevel(xdgSurface);
+        xdg_toplevel_add_listener(toplevel, &toplevelListener, this);
+        xdg_toplevel_set_title(toplevel, title.c_str());
+
+        // Same as the X11 size hints, the window is not resizable until SetResizable is called
+        xdg_toplevel_set_min_size(toplevel, width, height);
+        xdg_toplevel_set_max_size(toplevel, width, height);
+
+        // Commit without a buffer and wait for the initial configure before anything renders
+        wl_surface_commit(surface);
+        wl_display_roundtrip(display);
+
+        return true;
+    }
+
+    bool WaylandBackend::PollEvents()
+    {
+        // Dispatch whatever is already queued, then read what's on the socket without blocking
+        while (wl_display_prepare_read(display) != 0)
+        {
+            wl_display_dispatch_pending(display);
+        }
+        wl_display_flush(display);
+
+        struct pollfd fd;
+        fd.fd = wl_display_get_fd(display);
+        fd.events = POLLIN;
+        fd.revents = 0;
+
+        if (poll(&fd, 1, 0) > 0)
+        {
+            wl_display_read_events(display);
+        }
+        else
+        {
+            wl_display_cancel_read(display);
+        }
+
+        wl_display_dispatch_pending(display);
+        EmitRepeats();
+
+        return !closeRequested;
+    }
+
+    void WaylandBackend::EmitRepeats()
+    {
+        if (repeatKey == Key::KEY_UNKNOWN)
+        {
+            return;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        auto interval = std::chrono::nanoseconds(std::chrono::seconds(1)) / repeatRate;
+        for (int i = 0; i < MaxRepeatsPerPoll && nextRepeat <= now; i++)
+        {
+            // A press of a key that is already down, Window turns it into a KeyRepeatEvent
+            KeyDownEvent keyDownEvent;
+            keyDownEvent.key = repeatKey;
+            keyDownEvent.shift = HasModifier(modifiers, Modifier::Shift);
+            keyDownEvent.modifiers = modifiers;
+            // Wayland timestamps are CLOCK_MONOTONIC milliseconds, like steady_clock
+            keyDownEvent.serverTime = static_cast<uint32_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(nextRepeat.time_since_epoch()).count());
+            keyDownEvent.hostTime = now;
+            owner.DispatchEvent(keyDownEvent);
+
+            nextRepeat += interval;
+        }
+
+        if (nextRepeat <= now)
+        {
+            nextRepeat = now + interval;
+        }
+    }
+
+    bool WaylandBackend::HasPendingInput()
+    {
+        return repeatKey != Key::KEY_UNKNOWN && nextRepeat <= std::chrono::steady_clock::now();
+    }
+
+    void WaylandBackend::WaitForInput(const struct timespec *timeout, int wakeFd, int deviceFd)
+    {
+        if (wl_display_prepare_read(display) != 0)
+        {
+            // Events are already queued, nothing to wait for
+            return;
+        }
+        wl_display_flush(display);
+
+        // Wake up for the next key repeat
+        struct timespec repeatTimeout;
+        if (repeatKey != Key::KEY_UNKNOWN)
+        {
+            auto until = std::max(nextRepeat - std::chrono::steady_clock::now(), std::chrono::steady_clock::duration::zero());
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(until);
+            repeatTimeout.tv_sec = seconds.count();
+            repeatTimeout.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(until - seconds).count();
+
+            if (timeout == nullptr || repeatTimeout.tv_sec < timeout->tv_sec ||
+                (repeatTimeout.tv_sec == timeout->tv_sec && repeatTimeout.tv_nsec < timeout->tv_nsec))
+            {
+                timeout = &repeatTimeout;
+            }
+        }
+
+        struct pollfd fds[3];
+        fds[0].fd = wl_display_get_fd(display);
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = wakeFd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        fds[2].fd = deviceFd;
+        fds[2].events = POLLIN;
+        fds[2].revents = 0;
+
+        if (ppoll(fds, 3, timeout, nullptr) > 0 && (fds[0].revents & POLLIN))
+        {
+            wl_display_read_events(display);
+        }
+        else
+        {
+            wl_display_cancel_read(display);
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            uint64_t value;
+            ssize_t result = read(wakeFd, &value, sizeof(value));
+            (void)result;
+        }
+    }
+
+    void WaylandBackend::LockCursor()
+    {
+        if (cursorLocked)
+        {
+            return;
+        }
+
+        if (pointerConstraints == nullptr || relativePointerManager == nullptr || pointer == nullptr)
+        {
+            Flux::Error("Wayland compositor does not support pointer locking");
+            return;
+        }
+
+        lockedPointer = zwp_pointer_constraints_v1_lock_pointer(pointerConstraints, surface, pointer, nullptr,
+                                                                ZWP_POINTER_CONSTRAINTS_V1_LIFETIME_PERSISTENT);
+
+        relativeRemainderX = 0.0;
+        relativeRemainderY = 0.0;
+        cursorLocked = true;
+
+        SetCursorVisible(false);
+        wl_display_flush(display);
+    }
+
+    void WaylandBackend::UnlockCursor()
+    {
+        if (!cursorLocked)
+        {
+            return;
+        }
+
+        zwp_locked_pointer_v1_destroy(lockedPointer);
+        lockedPointer = nullptr;
+        cursorLocked = false;
+
+        SetCursorVisible(true);
+        wl_display_flush(display);
+    }
+
+    void WaylandBackend::SetResizable(bool resizable)
+    {
+        if (resizable)
+        {
+            // Zero removes the limit
+            xdg_toplevel_set_min_size(toplevel, 1, 1);
+            xdg_toplevel_set_max_size(toplevel, 0, 0);
+        }
+        else
+        {
+            xdg_toplevel_set_min_size(toplevel, owner.width, owner.height);
+            xdg_toplevel_set_max_size(toplevel, owner.width, owner.height);
+        }
+
+        wl_surface_commit(surface);
+        wl_display_flush(display);
+    }
+
+    void WaylandBackend::SetCursorVisible(bool visible)
+    {
+        if (pointer == nullptr)
+        {
+            return;
+        }
+
+        if (!visible || defaultCursor == nullptr || cursorSurface == nullptr)
+        {
+            wl_pointer_set_cursor(pointer, pointerEnterSerial, nullptr, 0, 0);
+            return;
+        }
+
+        wl_cursor_image *image = defaultCursor->images[0];
+        wl_surface_attach(cursorSurface, wl_cursor_image_get_buffer(image), 0, 0);
+        wl_surface_damage(cursorSurface, 0, 0, image->width, image->height);
+        wl_surface_commit(cursorSurface);
+        wl_pointer_set_cursor(pointer, pointerEnterSerial, cursorSurface, image->hotspot_x, image->hotspot_y);
+    }
+
+    void WaylandBackend::HandleGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+
+        if (strcmp(interface, wl_compositor_interface.name) == 0)
+        {
+            self->compositor = static_cast<wl_compositor *>(
+                wl_registry_bind(registry, name, &wl_compositor_interface, std::min(version, 4u)));
+        }
+        else if (strcmp(interface, wl_shm_interface.name) == 0)
+        {
+            self->shm = static_cast<wl_shm *>(wl_registry_bind(registry, name, &wl_shm_interface, 1));
+        }
+        else if (strcmp(interface, xdg_wm_base_interface.name) == 0)
+        {
+            self->wmBase = static_cast<xdg_wm_base *>(wl_registry_bind(registry, name, &xdg_wm_base_interface, 1));
+            xdg_wm_base_add_listener(self->wmBase, &wmBaseListener, self);
+        }
+        else if (strcmp(interface, wl_seat_interface.name) == 0 && self->seat == nullptr)
+        {
+            // Version 5 adds pointer frames, nothing newer is handled by the listeners
+            self->seat = static_cast<wl_seat *>(wl_registry_bind(registry, name, &wl_seat_interface, std::min(version, 5u)));
+            wl_seat_add_listener(self->seat, &seatListener, self);
+        }
+        else if (strcmp(interface, zwp_relative_pointer_manager_v1_interface.name) == 0)
+        {
+            self->relativePointerManager = static_cast<zwp_relative_pointer_manager_v1 *>(
+                wl_registry_bind(registry, name, &zwp_relative_pointer_manager_v1_interface, 1));
+        }
+        else if (strcmp(interface, zwp_pointer_constraints_v1_interface.name) == 0)
+        {
+            self->pointerConstraints = static_cast<zwp_pointer_constraints_v1 *>(
+                wl_registry_bind(registry, name, &zwp_pointer_constraints_v1_interface, 1));
+        }
+    }
+
+    void WaylandBackend::HandleGlobalRemove(void *, wl_registry *, uint32_t)
+    {
+    }
+
+    void WaylandBackend::HandleSeatCapabilities(void *data, wl_seat *seat, uint32_t capabilities)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+
+        bool hasKeyboard = capabilities & WL_SEAT_CAPABILITY_KEYBOARD;
+        if (hasKeyboard && self->keyboard == nullptr)
+        {
+            self->keyboard = wl_seat_get_keyboard(seat);
+            wl_keyboard_add_listener(self->keyboard, &keyboardListener, self);
+        }
+        else if (!hasKeyboard && self->keyboard != nullptr)
+        {
+            wl_keyboard_destroy(self->keyboard);
+            self->keyboard = nullptr;
+        }
+
+        bool hasPointer = capabilities & WL_SEAT_CAPABILITY_POINTER;
+        if (hasPointer && self->pointer == nullptr)
+        {
+            self->pointer = wl_seat_get_pointer(seat);
+            wl_pointer_add_listener(self->pointer, &pointerListener, self);
+
+            if (self->relativePointerManager != nullptr)
+            {
+                self->relativePointer = zwp_relative_pointer_manager_v1_get_relative_pointer(self->relativePointerManager, self->pointer);
+                zwp_relative_pointer_v1_add_listener(self->relativePointer, &relativePointerListener, self);
+            }
+        }
+        else if (!hasPointer && self->pointer != nullptr)
+        {
+            self->UnlockCursor();
+
+            if (self->relativePointer != nullptr)
+            {
+                zwp_relative_pointer_v1_destroy(self->relativePointer);
+                self->relativePointer = nullptr;
+            }
+
+            wl_pointer_destroy(self->pointer);
+            self->pointer = nullptr;
+        }
+    }
+
+    void WaylandBackend::HandleSeatName(void *, wl_seat *, const char *)
+    {
+    }
+
+    void WaylandBackend::HandleKeymap(void *, wl_keyboard *, uint32_t, int32_t fd, uint32_t)
+    {
+        // Keys are translated positionally from evdev codes, the keymap itself is not needed
+        close(fd);
+    }
+
+    void WaylandBackend::HandleKeyboardEnter(void *, wl_keyboard *, uint32_t, wl_surface *, wl_array *)
+    {
+    }
+
+    void WaylandBackend::HandleKeyboardLeave(void *data, wl_keyboard *, uint32_t, wl_surface *)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+        Window &owner = self->owner;
+        self->repeatKey = Key::KEY_UNKNOWN;
+
+        // Releases after leave go to the newly focused surface, so every key still held is released
+        // here or it would stay down in the key state and the action map
+        auto hostTime = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < static_cast<size_t>(Key::KEY_NUM_SCANCODES); i++)
+        {
+            Key key = static_cast<Key>(i);
+            if (!owner.keys.Test(key))
+            {
+                continue;
+            }
+
+            KeyUpEvent keyUpEvent;
+            keyUpEvent.key = key;
+            keyUpEvent.shift = HasModifier(self->modifiers, Modifier::Shift);
+            keyUpEvent.modifiers = self->modifiers;
+            keyUpEvent.hostTime = hostTime;
+            owner.DispatchEvent(keyUpEvent);
+        }
+    }
+
+    void WaylandBackend::HandleKey(void *data, wl_keyboard *, uint32_t, uint32_t time, uint32_t code, uint32_t state)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+        Window &owner = self->owner;
+
+        Key key = EvdevKeyToNovaKey(code);
+        if (key == Key::KEY_UNKNOWN)
+        {
+            return;
+        }
+
+        auto hostTime = std::chrono::steady_clock::now();
+
+        // Wayland never sends repeated presses, EmitRepeats generates them for the last pressed key
+        if (state == WL_KEYBOARD_KEY_STATE_PRESSED)
+        {
+            if (self->repeatRate > 0 && KeyRepeats(key))
+            {
+                self->repeatKey = key;
+                self->nextRepeat = hostTime + std::chrono::milliseconds(self->repeatDelay);
+            }
+
+            KeyDownEvent keyDownEvent;
+            keyDownEvent.key = key;
+            keyDownEvent.shift = HasModifier(self->modifiers, Modifier::Shift);
+            keyDownEvent.modifiers = self->modifiers;
+            keyDownEvent.serverTime = time;
+            keyDownEvent.hostTime = hostTime;
+            owner.DispatchEvent(keyDownEvent);
+        }
+        else
+        {
+            if (key == self->repeatKey)
+            {
+                self->repeatKey = Key::KEY_UNKNOWN;
+            }
+
+            KeyUpEvent keyUpEvent;
+            keyUpEvent.key = key;
+            keyUpEvent.shift = HasModifier(self->modifiers, Modifier::Shift);
+            keyUpEvent.modifiers = self->modifiers;
+            keyUpEvent.serverTime = time;
+            keyUpEvent.hostTime = hostTime;
+            owner.DispatchEvent(keyUpEvent);
+        }
+    }
+
+    void WaylandBackend::HandleModifiers(void *data, wl_keyboard *, uint32_t, uint32_t depressed, uint32_t latched, uint32_t locked, uint32_t)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+
+        // The first eight xkb modifiers are the core X modifiers
+        self->modifiers = ModifiersFromCoreMask(depressed | latched | locked);
+    }
+
+    void WaylandBackend::HandleRepeatInfo(void *data, wl_keyboard *, int32_t rate, int32_t delay)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+
+        self->repeatRate = rate;
+        self->repeatDelay = delay;
+        if (rate <= 0)
+        {
+            self->repeatKey = Key::KEY_UNKNOWN;
+        }
+    }
+
+    void WaylandBackend::HandlePointerEnter(void *data, wl_pointer *, uint32_t serial, wl_surface *, wl_fixed_t, wl_fixed_t)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+
+        self->pointerEnterSerial = serial;
+        self->SetCursorVisible(!self->cursorLocked);
+    }
+
+    void WaylandBackend::HandlePointerLeave(void *, wl_pointer *, uint32_t, wl_surface *)
+    {
+    }
+
+    void WaylandBackend::HandlePointerMotion(void *data, wl_pointer *, uint32_t time, wl_fixed_t x, wl_fixed_t y)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+
+        // While locked the pointer doesn't move, relative motion comes from zwp_relative_pointer_v1
+        if (self->cursorLocked)
+        {
+            return;
+        }
+
+        MouseMoveEvent mouseMoveEvent;
+        mouseMoveEvent.x = wl_fixed_to_int(x);
+        mouseMoveEvent.y = wl_fixed_to_int(y);
+        mouseMoveEvent.serverTime = time;
+        mouseMoveEvent.hostTime = std::chrono::steady_clock::now();
+        self->owner.DispatchEvent(mouseMoveEvent);
+    }
+
+    void WaylandBackend::HandlePointerButton(void *data, wl_pointer *, uint32_t, uint32_t time, uint32_t button, uint32_t state)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+
+        MouseButton mouseButton;
+        if (button == EvdevButtonLeft)
+        {
+            mouseButton = MouseButton::Left;
+        }
+        else if (button == EvdevButtonMiddle)
+        {
+            mouseButton = MouseButton::Middle;
+        }
+        else if (button == EvdevButtonRight)
+        {
+            mouseButton = MouseButton::Right;
+        }
+        else if (button == EvdevButtonSide)
+        {
+            mouseButton = MouseButton::Back;
+        }
+        else if (button == EvdevButtonExtra)
+        {
+            mouseButton = MouseButton::Forward;
+        }
+        else
+        {
+            return;
+        }
+
+        auto hostTime = std::chrono::steady_clock::now();
+
+        if (state == WL_POINTER_BUTTON_STATE_PRESSED)
+        {
+            MouseButtonDownEvent mouseDownEvent;
+            mouseDownEvent.button = mouseButton;
+            mouseDownEvent.serverTime = time;
+            mouseDownEvent.hostTime = hostTime;
+            self->owner.DispatchEvent(mouseDownEvent);
+        }
+        else
+        {
+            MouseButtonUpEvent mouseUpEvent;
+            mouseUpEvent.button = mouseButton;
+            mouseUpEvent.serverTime = time;
+            mouseUpEvent.hostTime = hostTime;
+            self->owner.DispatchEvent(mouseUpEvent);
+        }
+    }
+
+    void WaylandBackend::HandlePointerAxis(void *data, wl_pointer *pointer, uint32_t time, uint32_t axis, wl_fixed_t value)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+
+        int index = axis == WL_POINTER_AXIS_VERTICAL_SCROLL ? 0 : 1;
+        self->axisValue[index] += wl_fixed_to_double(value);
+        self->axisTime = time;
+        self->axisPending = true;
+
+        // Before version 5 there are no frames, every axis event stands alone
+        if (wl_pointer_get_version(pointer) < WL_POINTER_FRAME_SINCE_VERSION)
+        {
+            self->FlushAxis();
+        }
+    }
+
+    void WaylandBackend::HandlePointerFrame(void *data, wl_pointer *)
+    {
+        static_cast<WaylandBackend *>(data)->FlushAxis();
+    }
+
+    void WaylandBackend::FlushAxis()
+    {
+        if (!axisPending)
+        {
+            return;
+        }
+
+        // Wheels report whole detents through axis_discrete, which matches X11's one per click on
+        // any compositor scale. Touchpads and other continuous sources only have the surface
+        // distance. Positive values scroll down and right.
+        MouseScrollEvent scrollEvent;
+        scrollEvent.deltaY = axisDiscrete[0] != 0 ? -axisDiscrete[0] : -axisValue[0] / AxisUnitsPerDetent;
+        scrollEvent.deltaX = axisDiscrete[1] != 0 ? axisDiscrete[1] : axisValue[1] / AxisUnitsPerDetent;
+        scrollEvent.precise = (axisDiscrete[0] == 0 && axisValue[0] != 0.0) || (axisDiscrete[1] == 0 && axisValue[1] != 0.0);
+        scrollEvent.serverTime = axisTime;
+        scrollEvent.hostTime = std::chrono::steady_clock::now();
+
+        axisValue[0] = axisValue[1] = 0.0;
+        axisDiscrete[0] = axisDiscrete[1] = 0;
+        axisPending = false;
+
+        if (scrollEvent.deltaX != 0.0 || scrollEvent.deltaY != 0.0)
+        {
+            owner.DispatchEvent(scrollEvent);
+        }
+    }
+
+    void WaylandBackend::HandlePointerAxisSource(void *, wl_pointer *, uint32_t)
+    {
+    }
+
+    void WaylandBackend::HandlePointerAxisStop(void *, wl_pointer *, uint32_t, uint32_t)
+    {
+    }
+
+    void WaylandBackend::HandlePointerAxisDiscrete(void *data, wl_pointer *, uint32_t axis, int32_t discrete)
+    {
+        // Sent before the axis event of the same frame
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+        self->axisDiscrete[axis == WL_POINTER_AXIS_VERTICAL_SCROLL ? 0 : 1] += discrete;
+    }
+
+    void WaylandBackend::HandleRelativeMotion(void *data, zwp_relative_pointer_v1 *, uint32_t timeHigh, uint32_t timeLow,
+                                              wl_fixed_t, wl_fixed_t, wl_fixed_t dxUnaccelerated, wl_fixed_t dyUnaccelerated)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+
+        if (!self->cursorLocked)
+        {
+            return;
+        }
+
+        double dx = wl_fixed_to_double(dxUnaccelerated);
+        double dy = wl_fixed_to_double(dyUnaccelerated);
+
+        // Carry the fractional part over so integer deltas don't lose slow movement
+        self->relativeRemainderX += dx;
+        self->relativeRemainderY += dy;
+        int ix = static_cast<int>(self->relativeRemainderX);
+        int iy = static_cast<int>(self->relativeRemainderY);
+        self->relativeRemainderX -= ix;
+        self->relativeRemainderY -= iy;
+
+        // Relative motion is timestamped in microseconds, other events in milliseconds
+        uint64_t microseconds = (static_cast<uint64_t>(timeHigh) << 32) | timeLow;
+
+        MouseMoveEvent mouseMoveEvent;
+        mouseMoveEvent.x = ix;
+        mouseMoveEvent.y = iy;
+        mouseMoveEvent.relative = true;
+        mouseMoveEvent.deltaX = dx;
+        mouseMoveEvent.deltaY = dy;
+        mouseMoveEvent.serverTime = static_cast<uint32_t>(microseconds / 1000);
+        mouseMoveEvent.hostTime = std::chrono::steady_clock::now();
+        self->owner.DispatchEvent(mouseMoveEvent);
+    }
+
+    void WaylandBackend::HandleWmBasePing(void *, xdg_wm_base *wmBase, uint32_t serial)
+    {
+        xdg_wm_base_pong(wmBase, serial);
+    }
+
+    void WaylandBackend::HandleSurfaceConfigure(void *data, xdg_surface *xdgSurface, uint32_t serial)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+
+        xdg_surface_ack_configure(xdgSurface, serial);
+        wl_surface_commit(self->surface);
+    }
+
+    void WaylandBackend::HandleToplevelConfigure(void *data, xdg_toplevel *, int32_t width, int32_t height, wl_array *)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+
+        // Zero means the compositor leaves the size to us
+        if (width <= 0 || height <= 0)
+        {
+            return;
+        }
+
+        WindowResizeEvent resizeEvent;
+        resizeEvent.width = width;
+        resizeEvent.height = height;
+        resizeEvent.hostTime = std::chrono::steady_clock::now();
+        self->owner.DispatchEvent(resizeEvent);
+    }
+
+    void WaylandBackend::HandleToplevelClose(void *data, xdg_toplevel *)
+    {
+        WaylandBackend *self = static_cast<WaylandBackend *>(data);
+        self->closeRequested = true;
+    }
+}
+#endif
@@ -0,0 +1,151 @@
+#pragma once
+#ifdef NOVA_WAYLAND_BACKEND
+#include <wayland-client.h>
+#include <wayland-cursor.h>
+#include <Nova/Key.hpp>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+struct xdg_wm_base;
+struct xdg_surface;
+struct xdg_toplevel;
+struct zwp_relative_pointer_manager_v1;
+struct zwp_relative_pointer_v1;
+struct zwp_pointer_constraints_v1;
+struct zwp_locked_pointer_v1;
+struct xdg_wm_base_listener;
+struct xdg_surface_listener;
+struct xdg_toplevel_listener;
+struct zwp_relative_pointer_v1_listener;
+
+namespace Nova
+{
+    class Window;
+
+    /// @brief Native Wayland window using xdg-shell. Input from wl_seat is translated inside the
+    /// listener callbacks straight into the owning Window's event queue.
+    class WaylandBackend
+    {
+    private:
+        Window &owner;
+
+        wl_display *display = nullptr;
+        wl_registry *registry = nullptr;
+        wl_compositor *compositor = nullptr;
+        wl_seat *seat = nullptr;
+        wl_keyboard *keyboard = nullptr;
+        wl_pointer *pointer = nullptr;
+        wl_surface *surface = nullptr;
+        wl_shm *shm = nullptr;
+
+        wl_cursor_theme *cursorTheme = nullptr;
+        wl_cursor *defaultCursor = nullptr;
+        wl_surface *cursorSurface = nullptr;
+
+        xdg_wm_base *wmBase = nullptr;
+        xdg_surface *xdgSurface = nullptr;
+        xdg_toplevel *toplevel = nullptr;
+
+        zwp_relative_pointer_manager_v1 *relativePointerManager = nullptr;
+        zwp_relative_pointer_v1 *relativePointer = nullptr;
+        zwp_pointer_constraints_v1 *pointerConstraints = nullptr;
+        zwp_locked_pointer_v1 *lockedPointer = nullptr;
+
+        uint32_t pointerEnterSerial = 0;
+        // Depressed, latched and locked modifiers from the last wl_keyboard.modifiers
+        uint16_t modifiers = 0;
+        bool closeRequested = false;
+        bool cursorLocked = false;
+
+        double relativeRemainderX = 0.0;
+        double relativeRemainderY = 0.0;
+
+        // Compositors leave key repeat to the client. Rate and delay come from wl_keyboard.repeat_info,
+        // defaulting to the values the protocol suggests, and a rate of 0 disables repeat.
+        int32_t repeatRate = 25;
+        int32_t repeatDelay = 600;
+        Key repeatKey = Key::KEY_UNKNOWN;
+        std::chrono::steady_clock::time_point nextRepeat;
+
+        void EmitRepeats();
+
+        // Scroll of the current wl_pointer frame, vertical then horizontal
+        double axisValue[2] = {};
+        int32_t axisDiscrete[2] = {};
+        uint32_t axisTime = 0;
+        bool axisPending = false;
+
+        void FlushAxis();
+
+        static const wl_registry_listener registryListener;
+        static const wl_seat_listener seatListener;
+        static const wl_keyboard_listener keyboardListener;
+        static const wl_pointer_listener pointerListener;
+        static const zwp_relative_pointer_v1_listener relativePointerListener;
+        static const xdg_wm_base_listener wmBaseListener;
+        static const xdg_surface_listener surfaceListener;
+        static const xdg_toplevel_listener toplevelListener;
+
+        static void HandleGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version);
+        static void HandleGlobalRemove(void *data, wl_registry *registry, uint32_t name);
+
+        static void HandleSeatCapabilities(void *data, wl_seat *seat, uint32_t capabilities);
+        static void HandleSeatName(void *data, wl_seat *seat, const char *name);
+
+        static void HandleKeymap(void *data, wl_keyboard *keyboard, uint32_t format, int32_t fd, uint32_t size);
+        static void HandleKeyboardEnter(void *data, wl_keyboard *keyboard, uint32_t serial, wl_surface *surface, wl_array *keys);
+        static void HandleKeyboardLeave(void *data, wl_keyboard *keyboard, uint32_t serial, wl_surface *surface);
+        static void HandleKey(void *data, wl_keyboard *keyboard, uint32_t serial, uint32_t time, uint32_t key, uint32_t state);
+        static void HandleModifiers(void *data, wl_keyboard *keyboard, uint32_t serial, uint32_t depressed, uint32_t latched, uint32_t locked, uint32_t group);
+        static void HandleRepeatInfo(void *data, wl_keyboard *keyboard, int32_t rate, int32_t delay);
+
+        static void HandlePointerEnter(void *data, wl_pointer *pointer, uint32_t serial, wl_surface *surface, wl_fixed_t x, wl_fixed_t y);
+        static void HandlePointerLeave(void *data, wl_pointer *pointer, uint32_t serial, wl_surface *surface);
+        static void HandlePointerMotion(void *data, wl_pointer *pointer, uint32_t time, wl_fixed_t x, wl_fixed_t y);
+        static void HandlePointerButton(void *data, wl_pointer *pointer, uint32_t serial, uint32_t time, uint32_t button, uint32_t state);
+        static void HandlePointerAxis(void *data, wl_pointer *pointer, uint32_t time, uint32_t axis, wl_fixed_t value);
+        static void HandlePointerFrame(void *data, wl_pointer *pointer);
+        static void HandlePointerAxisSource(void *data, wl_pointer *pointer, uint32_t source);
+        static void HandlePointerAxisStop(void *data, wl_pointer *pointer, uint32_t time, uint32_t axis);
+        static void HandlePointerAxisDiscrete(void *data, wl_pointer *pointer, uint32_t axis, int32_t discrete);
+
+        static void HandleRelativeMotion(void *data, zwp_relative_pointer_v1 *relativePointer, uint32_t timeHigh, uint32_t timeLow,
+                                         wl_fixed_t dx, wl_fixed_t dy, wl_fixed_t dxUnaccelerated, wl_fixed_t dyUnaccelerated);
+
+        static void HandleWmBasePing(void *data, xdg_wm_base *wmBase, uint32_t serial);
+        static void HandleSurfaceConfigure(void *data, xdg_surface *xdgSurface, uint32_t serial);
+        static void HandleToplevelConfigure(void *data, xdg_toplevel *toplevel, int32_t width, int32_t height, wl_array *states);
+        static void HandleToplevelClose(void *data, xdg_toplevel *toplevel);
+
+        void SetCursorVisible(bool visible);
+
+    public:
+        explicit WaylandBackend(Window &owner);
+        ~WaylandBackend();
+
+        WaylandBackend(const WaylandBackend &) = delete;
+        WaylandBackend &operator=(const WaylandBackend &) = delete;
+
+        /// @brief Connects to the compositor and creates the toplevel, returns false if Wayland is unavailable
+        bool Create(const std::string &title, int width, int height);
+
+        /// @brief Reads and dispatches everything the compositor has sent, returns false once the window was closed
+        bool PollEvents();
+
+        /// @brief Listeners run inside PollEvents, so only a due key repeat can be pending between polls
+        bool HasPendingInput();
+
+        /// @brief Sleeps until the compositor sends something, wakeFd becomes readable or the timeout passes
+        void WaitForInput(const struct timespec *timeout, int wakeFd, int deviceFd);
+
+        void LockCursor();
+        void UnlockCursor();
+
+        void SetResizable(bool resizable);
+
+        wl_display *GetDisplay() const { return display; }
+        wl_surface *GetSurface() const { return surface; }
+    };
+}
+#endif
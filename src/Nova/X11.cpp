@@ -0,0 +1,1854 @@
+#include <Nova/Nova.hpp>
+#include <Nova/X11.hpp>
+#include <Nova/DisplayContext.hpp>
+#include <Flux/Flux.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <vector>
+#include <X11/XF86keysym.h>
+#include <X11/XKBlib.h>
+
+namespace Nova
+{
+    Key X11KeySymToNovaKey(KeySym keysym)
+    {
+        switch (keysym)
+        {
+        case XK_a:
+        case XK_A:
+            return Key::KEY_A;
+        case XK_b:
+        case XK_B:
+            return Key::KEY_B;
+        case XK_c:
+        case XK_C:
+            return Key::KEY_C;
+        case XK_d:
+        case XK_D:
+            return Key::KEY_D;
+        case XK_e:
+        case XK_E:
+            return Key::KEY_E;
+        case XK_f:
+        case XK_F:
+            return Key::KEY_F;
+        case XK_g:
+        case XK_G:
+            return Key::KEY_G;
+        case XK_h:
+        case XK_H:
+            return Key::KEY_H;
+        case XK_i:
+        case XK_I:
+            return Key::KEY_I;
+        case XK_j:
+        case XK_J:
+            return Key::KEY_J;
+        case XK_k:
+        case XK_K:
+            return Key::KEY_K;
+        case XK_l:
+        case XK_L:
+            return Key::KEY_L;
+        case XK_m:
+        case XK_M:
+            return Key::KEY_M;
+        case XK_n:
+        case XK_N:
+            return Key::KEY_N;
+        case XK_o:
+        case XK_O:
+            return Key::KEY_O;
+        case XK_p:
+        case XK_P:
+            return Key::KEY_P;
+        case XK_q:
+        case XK_Q:
+            return Key::KEY_Q;
+        case XK_r:
+        case XK_R:
+            return Key::KEY_R;
+        case XK_s:
+        case XK_S:
+            return Key::KEY_S;
+        case XK_t:
+        case XK_T:
+            return Key::KEY_T;
+        case XK_u:
+        case XK_U:
+            return Key::KEY_U;
+        case XK_v:
+        case XK_V:
+            return Key::KEY_V;
+        case XK_w:
+        case XK_W:
+            return Key::KEY_W;
+        case XK_x:
+        case XK_X:
+            return Key::KEY_X;
+        case XK_y:
+        case XK_Y:
+            return Key::KEY_Y;
+        case XK_z:
+        case XK_Z:
+            return Key::KEY_Z;
+
+        case XK_1:
+            return Key::KEY__1;
+        case XK_2:
+            return Key::KEY__2;
+        case XK_3:
+            return Key::KEY__3;
+        case XK_4:
+            return Key::KEY__4;
+        case XK_5:
+            return Key::KEY__5;
+        case XK_6:
+            return Key::KEY__6;
+        case XK_7:
+            return Key::KEY__7;
+        case XK_8:
+            return Key::KEY__8;
+        case XK_9:
+            return Key::KEY__9;
+        case XK_0:
+            return Key::KEY__0;
+
+        case XK_Return:
+            return Key::KEY_RETURN;
+        case XK_Escape:
+            return Key::KEY_ESCAPE;
+        case XK_BackSpace:
+            return Key::KEY_BACKSPACE;
+        case XK_Tab:
+            return Key::KEY_TAB;
+        case XK_space:
+            return Key::KEY_SPACE;
+        case XK_minus:
+            return Key::KEY_MINUS;
+        case XK_equal:
+            return Key::KEY_EQUALS;
+        case XK_bracketleft:
+            return Key::KEY_LEFTBRACKET;
+        case XK_bracketright:
+            return Key::KEY_RIGHTBRACKET;
+        case XK_backslash:
+            return Key::KEY_BACKSLASH;
+        case XK_semicolon:
+            return Key::KEY_SEMICOLON;
+        case XK_apostrophe:
+            return Key::KEY_APOSTROPHE;
+        case XK_grave:
+            return Key::KEY_GRAVE;
+        case XK_comma:
+            return Key::KEY_COMMA;
+        case XK_period:
+            return Key::KEY_PERIOD;
+        case XK_slash:
+            return Key::KEY_SLASH;
+        case XK_Caps_Lock:
+            return Key::KEY_CAPSLOCK;
+
+        case XK_F1:
+            return Key::KEY_F1;
+        case XK_F2:
+            return Key::KEY_F2;
+        case XK_F3:
+            return Key::KEY_F3;
+        case XK_F4:
+            return Key::KEY_F4;
+        case XK_F5:
+            return Key::KEY_F5;
+        case XK_F6:
+            return Key::KEY_F6;
+        case XK_F7:
+            return Key::KEY_F7;
+        case XK_F8:
+            return Key::KEY_F8;
+        case XK_F9:
+            return Key::KEY_F9;
+        case XK_F10:
+            return Key::KEY_F10;
+        case XK_F11:
+            return Key::KEY_F11;
+        case XK_F12:
+            return Key::KEY_F12;
+
+        case XK_Print:
+            return Key::KEY_PRINTSCREEN;
+        case XK_Scroll_Lock:
+            return Key::KEY_SCROLLLOCK;
+        case XK_Pause:
+            return Key::KEY_PAUSE;
+        case XK_Insert:
+            return Key::KEY_INSERT;
+        case XK_Home:
+            return Key::KEY_HOME;
+        case XK_Page_Up:
+            return Key::KEY_PAGEUP;
+        case XK_Delete:
+            return Key::KEY_DELETE;
+        case XK_End:
+            return Key::KEY_END;
+        case XK_Page_Down:
+            return Key::KEY_PAGEDOWN;
+        case XK_Right:
+            return Key::KEY_RIGHT;
+        case XK_Left:
+            return Key::KEY_LEFT;
+        case XK_Down:
+            return Key::KEY_DOWN;
+        case XK_Up:
+            return Key::KEY_UP;
+
+        case XK_Num_Lock:
+            return Key::KEY_NUMLOCKCLEAR;
+        case XK_KP_Divide:
+            return Key::KEY_KP_DIVIDE;
+        case XK_KP_Multiply:
+            return Key::KEY_KP_MULTIPLY;
+        case XK_KP_Subtract:
+            return Key::KEY_KP_MINUS;
+        case XK_KP_Add:
+            return Key::KEY_KP_PLUS;
+        case XK_KP_Enter:
+            return Key::KEY_KP_ENTER;
+        case XK_KP_1:
+            return Key::KEY_KP_1;
+        case XK_KP_2:
+            return Key::KEY_KP_2;
+        case XK_KP_3:
+            return Key::KEY_KP_3;
+        case XK_KP_4:
+            return Key::KEY_KP_4;
+        case XK_KP_5:
+            return Key::KEY_KP_5;
+        case XK_KP_6:
+            return Key::KEY_KP_6;
+        case XK_KP_7:
+            return Key::KEY_KP_7;
+        case XK_KP_8:
+            return Key::KEY_KP_8;
+        case XK_KP_9:
+            return Key::KEY_KP_9;
+        case XK_KP_0:
+            return Key::KEY_KP_0;
+        case XK_KP_Decimal:
+            return Key::KEY_KP_PERIOD;
+
+        case XK_Control_L:
+            return Key::KEY_LCTRL;
+        case XK_Shift_L:
+            return Key::KEY_LSHIFT;
+        case XK_Alt_L:
+            return Key::KEY_LALT;
+        case XK_Super_L:
+            return Key::KEY_LGUI;
+        case XK_Control_R:
+            return Key::KEY_RCTRL;
+        case XK_Shift_R:
+            return Key::KEY_RSHIFT;
+        case XK_Alt_R:
+            return Key::KEY_RALT;
+        case XK_Super_R:
+            return Key::KEY_RGUI;
+
+        case XK_F13:
+            return Key::KEY_F13;
+        case XK_F14:
+            return Key::KEY_F14;
+        case XK_F15:
+            return Key::KEY_F15;
+        case XK_F16:
+            return Key::KEY_F16;
+        case XK_F17:
+            return Key::KEY_F17;
+        case XK_F18:
+            return Key::KEY_F18;
+        case XK_F19:
+            return Key::KEY_F19;
+        case XK_F20:
+            return Key::KEY_F20;
+        case XK_F21:
+            return Key::KEY_F21;
+        case XK_F22:
+            return Key::KEY_F22;
+        case XK_F23:
+            return Key::KEY_F23;
+        case XK_F24:
+            return Key::KEY_F24;
+        case XK_KP_Equal:
+            return Key::KEY_KP_EQUALS;
+        case XK_KP_Separator:
+            return Key::KEY_KP_COMMA;
+        case XK_Menu:
+            return Key::KEY_MENU;
+        case XK_less:
+            return Key::KEY_NONUSBACKSLASH;
+        case XK_Sys_Req:
+            return Key::KEY_SYSREQ;
+        case XK_Execute:
+            return Key::KEY_EXECUTE;
+        case XK_Help:
+            return Key::KEY_HELP;
+        case XK_Select:
+            return Key::KEY_SELECT;
+        case XK_Cancel:
+            return Key::KEY_CANCEL;
+        case XK_Undo:
+            return Key::KEY_UNDO;
+        case XK_Find:
+            return Key::KEY_FIND;
+        case XK_Clear:
+            return Key::KEY_CLEAR;
+        case XK_Mode_switch:
+            return Key::KEY_MODE;
+        case XK_ISO_Level3_Shift:
+            return Key::KEY_RALT;
+        case XF86XK_AudioPlay:
+            return Key::KEY_AUDIOPLAY;
+        case XF86XK_AudioStop:
+            return Key::KEY_AUDIOSTOP;
+        case XF86XK_AudioPrev:
+            return Key::KEY_AUDIOPREV;
+        case XF86XK_AudioNext:
+            return Key::KEY_AUDIONEXT;
+        case XF86XK_AudioRewind:
+            return Key::KEY_AUDIOREWIND;
+        case XF86XK_AudioForward:
+            return Key::KEY_AUDIOFASTFORWARD;
+        case XF86XK_AudioMute:
+            return Key::KEY_MUTE;
+        case XF86XK_AudioRaiseVolume:
+            return Key::KEY_VOLUMEUP;
+        case XF86XK_AudioLowerVolume:
+            return Key::KEY_VOLUMEDOWN;
+        case XF86XK_AudioMedia:
+            return Key::KEY_MEDIASELECT;
+        case XF86XK_WWW:
+            return Key::KEY_WWW;
+        case XF86XK_Mail:
+            return Key::KEY_MAIL;
+        case XF86XK_Calculator:
+            return Key::KEY_CALCULATOR;
+        case XF86XK_MyComputer:
+            return Key::KEY_COMPUTER;
+        case XF86XK_Search:
+            return Key::KEY_AC_SEARCH;
+        case XF86XK_HomePage:
+            return Key::KEY_AC_HOME;
+        case XF86XK_Back:
+            return Key::KEY_AC_BACK;
+        case XF86XK_Forward:
+            return Key::KEY_AC_FORWARD;
+        case XF86XK_Stop:
+            return Key::KEY_AC_STOP;
+        case XF86XK_Refresh:
+            return Key::KEY_AC_REFRESH;
+        case XF86XK_Favorites:
+            return Key::KEY_AC_BOOKMARKS;
+        case XF86XK_MonBrightnessDown:
+            return Key::KEY_BRIGHTNESSDOWN;
+        case XF86XK_MonBrightnessUp:
+            return Key::KEY_BRIGHTNESSUP;
+        case XF86XK_Display:
+            return Key::KEY_DISPLAYSWITCH;
+        case XF86XK_KbdLightOnOff:
+            return Key::KEY_KBDILLUMTOGGLE;
+        case XF86XK_KbdBrightnessDown:
+            return Key::KEY_KBDILLUMDOWN;
+        case XF86XK_KbdBrightnessUp:
+            return Key::KEY_KBDILLUMUP;
+        case XF86XK_Eject:
+            return Key::KEY_EJECT;
+        case XF86XK_Sleep:
+            return Key::KEY_SLEEP;
+        case XF86XK_PowerOff:
+            return Key::KEY_POWER;
+        case XF86XK_Launch0:
+            return Key::KEY_APP1;
+        case XF86XK_Launch1:
+            return Key::KEY_APP2;
+        default:
+            return Key::KEY_UNKNOWN;
+        }
+    }
+
+    // Events the main connection always selects, and the input events that move to the input
+    // thread's connection when it is running
+    static constexpr long WindowEventMask = ExposureMask | StructureNotifyMask;
+    static constexpr long InputEventMask = KeyPressMask | KeyReleaseMask | ButtonPressMask |
+                                           ButtonReleaseMask | PointerMotionMask | FocusChangeMask;
+
+    static size_t EncodeUtf8(uint32_t codepoint, char *out)
+    {
+        if (codepoint < 0x80)
+        {
+            out[0] = static_cast<char>(codepoint);
+            return 1;
+        }
+        if (codepoint < 0x800)
+        {
+            out[0] = static_cast<char>(0xC0 | (codepoint >> 6));
+            out[1] = static_cast<char>(0x80 | (codepoint & 0x3F));
+            return 2;
+        }
+        if (codepoint < 0x10000)
+        {
+            out[0] = static_cast<char>(0xE0 | (codepoint >> 12));
+            out[1] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out[2] = static_cast<char>(0x80 | (codepoint & 0x3F));
+            return 3;
+        }
+        out[0] = static_cast<char>(0xF0 | (codepoint >> 18));
+        out[1] = static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        out[2] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out[3] = static_cast<char>(0x80 | (codepoint & 0x3F));
+        return 4;
+    }
+
+    X11TextInput::~X11TextInput()
+    {
+        Close();
+    }
+
+    long X11TextInput::Open(Display *display, X11Window window)
+    {
+        // An empty modifier list picks the input method from XMODIFIERS, e.g. @im=ibus
+        if (XSupportsLocale())
+        {
+            XSetLocaleModifiers("");
+        }
+
+        method = XOpenIM(display, nullptr, nullptr, nullptr);
+        if (method == nullptr)
+        {
+            Flux::Info("No X input method available, text input falls back to keysyms");
+            return 0;
+        }
+
+        // Nova draws no preedit or status area, the input method has to show them itself
+        XIMStyles *styles = nullptr;
+        bool supported = false;
+        if (XGetIMValues(method, XNQueryInputStyle, &styles, nullptr) == nullptr && styles != nullptr)
+        {
+            for (unsigned int i = 0; i < styles->count_styles; i++)
+            {
+                if (styles->supported_styles[i] == (XIMPreeditNothing | XIMStatusNothing))
+                {
+                    supported = true;
+                    break;
+                }
+            }
+            XFree(styles);
+        }
+
+        if (supported)
+        {
+            context = XCreateIC(method, XNInputStyle, XIMPreeditNothing | XIMStatusNothing, XNClientWindow, window,
+                                XNFocusWindow, window, nullptr);
+        }
+
+        if (context == nullptr)
+        {
+            Flux::Info("Unable to create an X input context, text input falls back to keysyms");
+            XCloseIM(method);
+            method = nullptr;
+            return 0;
+        }
+
+        long filterEvents = 0;
+        XGetICValues(context, XNFilterEvents, &filterEvents, nullptr);
+        XSetICFocus(context);
+        return filterEvents;
+    }
+
+    void X11TextInput::Close()
+    {
+        if (context != nullptr)
+        {
+            XDestroyIC(context);
+            context = nullptr;
+        }
+        if (method != nullptr)
+        {
+            XCloseIM(method);
+            method = nullptr;
+        }
+    }
+
+    bool X11TextInput::Filter(XEvent &event)
+    {
+        return context != nullptr && XFilterEvent(&event, None);
+    }
+
+    bool X11TextInput::IsDuplicatePress(unsigned int keycode, Time time)
+    {
+        if (context == nullptr || time == 0)
+        {
+            return false;
+        }
+
+        Time &last = pressTimes[keycode & 0xFF];
+        if (last == time)
+        {
+            return true;
+        }
+        last = time;
+        return false;
+    }
+
+    void X11TextInput::SetFocus(bool focused)
+    {
+        if (context == nullptr)
+        {
+            return;
+        }
+
+        if (focused)
+        {
+            XSetICFocus(context);
+        }
+        else
+        {
+            XUnsetICFocus(context);
+        }
+    }
+
+    size_t X11TextInput::Lookup(XKeyEvent &event, char *buffer, size_t size)
+    {
+        if (context != nullptr)
+        {
+            Status status;
+            int length = Xutf8LookupString(context, &event, buffer, static_cast<int>(size) - 1, nullptr, &status);
+            if (status == XBufferOverflow)
+            {
+                return static_cast<size_t>(length) + 1;
+            }
+            if (status != XLookupChars && status != XLookupBoth)
+            {
+                return 0;
+            }
+
+            buffer[length] = '\0';
+            return static_cast<size_t>(length);
+        }
+
+        // Without an input method only keysyms that name a character can be typed
+        KeySym keysym = NoSymbol;
+        XLookupString(&event, nullptr, 0, &keysym, nullptr);
+
+        uint32_t codepoint = 0;
+        if ((keysym >= 0x20 && keysym <= 0x7E) || (keysym >= 0xA0 && keysym <= 0xFF))
+        {
+            codepoint = static_cast<uint32_t>(keysym);
+        }
+        else if ((keysym & 0xFF000000) == 0x01000000)
+        {
+            codepoint = static_cast<uint32_t>(keysym & 0x00FFFFFF);
+        }
+
+        if (codepoint == 0 || size < 5)
+        {
+            return 0;
+        }
+
+        size_t length = EncodeUtf8(codepoint, buffer);
+        buffer[length] = '\0';
+        return length;
+    }
+
+    bool X11Atoms::Load(Display *display)
+    {
+        static const char *names[] = {
+            "WM_PROTOCOLS",
+            "WM_DELETE_WINDOW",
+            "_NET_WM_PING",
+            "_NET_WM_STATE",
+            "_NET_WM_STATE_FULLSCREEN",
+            "_NET_WM_STATE_MAXIMIZED_VERT",
+            "_NET_WM_STATE_MAXIMIZED_HORZ",
+            "_NET_WM_STATE_ABOVE",
+            "_NET_WM_STATE_HIDDEN",
+            "_NET_WM_BYPASS_COMPOSITOR",
+            "CLIPBOARD",
+            "UTF8_STRING",
+        };
+
+        Atom *targets[] = {
+            &WM_PROTOCOLS,
+            &WM_DELETE_WINDOW,
+            &NET_WM_PING,
+            &NET_WM_STATE,
+            &NET_WM_STATE_FULLSCREEN,
+            &NET_WM_STATE_MAXIMIZED_VERT,
+            &NET_WM_STATE_MAXIMIZED_HORZ,
+            &NET_WM_STATE_ABOVE,
+            &NET_WM_STATE_HIDDEN,
+            &NET_WM_BYPASS_COMPOSITOR,
+            &CLIPBOARD,
+            &UTF8_STRING,
+        };
+
+        static_assert(sizeof(names) / sizeof(names[0]) == sizeof(targets) / sizeof(targets[0]),
+                      "Every atom needs a name");
+
+        constexpr int count = sizeof(names) / sizeof(names[0]);
+        Atom results[count];
+        if (!XInternAtoms(display, const_cast<char **>(names), count, False, results))
+        {
+            return false;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            *targets[i] = results[i];
+        }
+        return true;
+    }
+
+    X11Backend::X11Backend(Window &owner)
+        : owner(owner)
+    {
+    }
+
+    X11Backend::~X11Backend()
+    {
+        if (display == nullptr)
+        {
+            return;
+        }
+
+        StopInputThread();
+        UnlockCursor();
+        framebuffer.reset();
+        textInput.Close();
+
+        if (context != nullptr)
+        {
+            context->Unregister(this);
+
+            // Raw event cookies were claimed by the context, nobody else frees them
+            X11RoutedEvent routed;
+            while (sharedEvents->Pop(routed))
+            {
+#ifdef NOVA_HAS_XINPUT2
+                if (routed.event.type == GenericEvent && routed.event.xcookie.data != nullptr)
+                {
+                    XFreeEventData(display, &routed.event.xcookie);
+                }
+#endif
+            }
+
+            XDestroyWindow(display, window);
+            XFlush(display);
+            return;
+        }
+
+        XDestroyWindow(display, window);
+        XCloseDisplay(display);
+    }
+
+    bool X11Backend::Create(const std::string &title, int width, int height)
+    {
+        display = XOpenDisplay(nullptr);
+        if (display == nullptr)
+        {
+            return false;
+        }
+
+        if (!atoms.Load(display))
+        {
+            Flux::Error("Unable to intern X atoms");
+        }
+
+        return CreateWindow(title, width, height);
+    }
+
+    bool X11Backend::Create(DisplayContext &context, const std::string &title, int width, int height)
+    {
+        if (!context.IsValid())
+        {
+            return false;
+        }
+
+        // Borrowed, the context interned the atoms once for all of its windows
+        display = context.display;
+        atoms = context.atoms;
+
+        if (!CreateWindow(title, width, height))
+        {
+            return false;
+        }
+
+        this->context = &context;
+        sharedEvents = std::make_unique<RingBuffer<X11RoutedEvent>>(Window::EventQueueCapacity);
+        context.Register(this);
+        return true;
+    }
+
+    bool X11Backend::CreateWindow(const std::string &title, int width, int height)
+    {
+        screen = DefaultScreen(display);
+        X11Window root = RootWindow(display, screen);
+
+        window = XCreateSimpleWindow(display, root, 100, 100, width, height, 1,
+                                     BlackPixel(display, screen),
+                                     BlackPixel(display, screen));
+
+        XStoreName(display, window, title.c_str());
+
+        // Register WM_DELETE_WINDOW and _NET_WM_PING, so the window manager can close the window
+        // and check that it still responds
+        Atom protocols[] = { atoms.WM_DELETE_WINDOW, atoms.NET_WM_PING };
+        XSetWMProtocols(display, window, protocols, 2);
+
+        // Select input events, plus whatever the input method needs to see
+        textInputEventMask = textInput.Open(display, window);
+        XSelectInput(display, window, WindowEventMask | InputEventMask | textInputEventMask);
+
+
+        // Windows start with a fixed size until SetResizable is called
+        SetResizable(false);
+
+#ifdef NOVA_HAS_XINPUT2
+        int xiEvent, xiError;
+        if (XQueryExtension(display, "XInputExtension", &xiOpcode, &xiEvent, &xiError))
+        {
+            // 2.1 adds smooth scrolling, the server answers with the version both sides support
+            int major = 2;
+            int minor = 1;
+            if (XIQueryVersion(display, &major, &minor) != Success)
+            {
+                Flux::Info("XInput2 not supported, locked cursor will fall back to pointer warping");
+                xiOpcode = -1;
+            }
+            else if (major > 2 || minor >= 1)
+            {
+                smoothScroll = SelectPointerEvents(display, true);
+            }
+        }
+        else
+        {
+            xiOpcode = -1;
+        }
+#endif
+
+        BuildKeycodeTable(display);
+        detectableAutoRepeat = EnableDetectableAutoRepeat(display);
+
+        XMapWindow(display, window);
+        XFlush(display); // Important: ensure window is created before WebGPU init
+
+        return true;
+    }
+
+    bool X11Backend::PollEvents()
+    {
+        if (context != nullptr)
+        {
+            // Reading the connection also fills the queues of the context's other windows
+            context->Pump();
+
+            X11RoutedEvent routed;
+            while (sharedEvents->Pop(routed))
+            {
+                if (!ProcessXEvent(display, routed.event, routed.hostTime))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        while (XPending(display) > 0)
+        { // Changed to 'while' to process all events
+            XEvent event;
+            XNextEvent(display, &event);
+
+            if (!ProcessXEvent(display, event, std::chrono::steady_clock::now()))
+            {
+                return false;
+            }
+        }
+
+        if (inputRing)
+        {
+            // Input translated by the input thread since the last poll
+            Event event;
+            while (inputRing->Pop(event))
+            {
+                owner.DispatchEvent(event);
+            }
+
+            owner.droppedEvents += inputDroppedEvents.exchange(0, std::memory_order_relaxed);
+        }
+
+        return true;
+    }
+
+    bool X11Backend::ProcessXEvent(Display *source, XEvent &event, std::chrono::steady_clock::time_point hostTime)
+    {
+        // The input thread runs this too, only the main thread's connection may look at framebuffer
+        if (source == display && framebuffer && framebuffer->HandleEvent(event))
+        {
+            return true;
+        }
+
+        // Some input methods clear the keycode while filtering, the key event still needs it
+        unsigned int keycode = event.xkey.keycode;
+        X11TextInput &sourceTextInput = TextInputFor(source);
+        bool filtered = sourceTextInput.Filter(event);
+
+        switch (event.type)
+        {
+        case KeyPress:
+        {
+            Key key = keycodeTable[keycode & 0xFF];
+            uint16_t modifiers = ModifiersFromCoreMask(event.xkey.state);
+
+            // Window turns presses of keys that are already down into KeyRepeatEvents
+            if (key != Key::KEY_UNKNOWN && !sourceTextInput.IsDuplicatePress(keycode, event.xkey.time))
+            {
+                KeyDownEvent keyDownEvent;
+                keyDownEvent.key = key;
+                keyDownEvent.modifiers = modifiers;
+                keyDownEvent.shift = HasModifier(modifiers, Modifier::Shift);
+                keyDownEvent.serverTime = event.xkey.time;
+                keyDownEvent.hostTime = hostTime;
+                EmitEvent(source, keyDownEvent);
+            }
+
+            // A filtered press is part of a compose or input method sequence, the text arrives later
+            if (!filtered)
+            {
+                char text[64];
+                size_t length = sourceTextInput.Lookup(event.xkey, text, sizeof(text));
+                if (length < sizeof(text))
+                {
+                    EmitText(source, text, length, event.xkey, hostTime);
+                }
+                else
+                {
+                    std::vector<char> largeText(length);
+                    length = sourceTextInput.Lookup(event.xkey, largeText.data(), largeText.size());
+                    EmitText(source, largeText.data(), length < largeText.size() ? length : 0, event.xkey, hostTime);
+                }
+            }
+            break;
+        }
+
+        case KeyRelease:
+        {
+            Key key = keycodeTable[keycode & 0xFF];
+
+            // Without detectable auto-repeat, a repeat shows up as a release followed by a press
+            // with the same timestamp. On a context the press was already routed out of Xlib's queue.
+            bool hasNext = false;
+            XEvent next_event;
+            if (!detectableAutoRepeat && context != nullptr)
+            {
+                hasNext = !sharedEvents->Empty();
+                if (hasNext)
+                {
+                    next_event = sharedEvents->Front().event;
+                }
+            }
+            else if (!detectableAutoRepeat && XEventsQueued(source, QueuedAfterReading))
+            {
+                hasNext = true;
+                XPeekEvent(source, &next_event);
+            }
+
+            if (hasNext && next_event.type == KeyPress &&
+                next_event.xkey.keycode == keycode &&
+                next_event.xkey.time == event.xkey.time)
+            {
+                // Auto-repeat event, skip this release
+                break;
+            }
+
+            if (key != Key::KEY_UNKNOWN)
+            {
+                KeyUpEvent keyUpEvent;
+                keyUpEvent.key = key;
+                keyUpEvent.modifiers = ModifiersFromCoreMask(event.xkey.state);
+                keyUpEvent.shift = HasModifier(keyUpEvent.modifiers, Modifier::Shift);
+                keyUpEvent.serverTime = event.xkey.time;
+                keyUpEvent.hostTime = hostTime;
+                EmitEvent(source, keyUpEvent);
+            }
+            break;
+        }
+
+        case MotionNotify:
+            EmitPointerMotion(source, event.xmotion.x, event.xmotion.y, event.xmotion.time, hostTime);
+            break;
+
+        case FocusIn:
+        case FocusOut:
+            sourceTextInput.SetFocus(event.type == FocusIn);
+            break;
+
+        case ButtonPress:
+        case ButtonRelease:
+            EmitButton(source, event.xbutton.button, event.type == ButtonPress, event.xbutton.time, hostTime);
+            break;
+
+#ifdef NOVA_HAS_XINPUT2
+        case GenericEvent:
+        {
+            // Events routed by a DisplayContext arrive with their data already claimed
+            if (event.xcookie.extension != xiOpcode || (event.xcookie.data == nullptr && !XGetEventData(source, &event.xcookie)))
+            {
+                break;
+            }
+
+            if (event.xcookie.evtype == XI_RawMotion && rawMotion)
+            {
+                XIRawEvent *rawEvent = static_cast<XIRawEvent *>(event.xcookie.data);
+
+                // raw_values only holds the valuators whose bit is set in the mask, 0 is x and 1 is y
+                double dx = 0.0;
+                double dy = 0.0;
+                const double *value = rawEvent->raw_values;
+                for (int i = 0; i < rawEvent->valuators.mask_len * 8 && i < 2; i++)
+                {
+                    if (XIMaskIsSet(rawEvent->valuators.mask, i))
+                    {
+                        if (i == 0)
+                        {
+                            dx = *value;
+                        }
+                        else
+                        {
+                            dy = *value;
+                        }
+                        value++;
+                    }
+                }
+
+                if (dx != 0.0 || dy != 0.0)
+                {
+                    // Carry the fractional part over so integer deltas don't lose slow movement
+                    rawRemainderX += dx;
+                    rawRemainderY += dy;
+                    int ix = static_cast<int>(rawRemainderX);
+                    int iy = static_cast<int>(rawRemainderY);
+                    rawRemainderX -= ix;
+                    rawRemainderY -= iy;
+
+                    MouseMoveEvent mouseMoveEvent;
+                    mouseMoveEvent.x = ix;
+                    mouseMoveEvent.y = iy;
+                    mouseMoveEvent.relative = true;
+                    mouseMoveEvent.deltaX = dx;
+                    mouseMoveEvent.deltaY = dy;
+                    mouseMoveEvent.serverTime = rawEvent->time;
+                    mouseMoveEvent.hostTime = hostTime;
+                    EmitEvent(source, mouseMoveEvent);
+                }
+            }
+            else if (event.xcookie.evtype == XI_Motion)
+            {
+                XIDeviceEvent *deviceEvent = static_cast<XIDeviceEvent *>(event.xcookie.data);
+
+                // Scroll valuators are absolute, the change since the last event in increments is the
+                // scroll delta. Any other valuator means the pointer moved.
+                double scrollX = 0.0;
+                double scrollY = 0.0;
+                bool scrolled = false;
+                bool moved = false;
+                const double *value = deviceEvent->valuators.values;
+                for (int i = 0; i < deviceEvent->valuators.mask_len * 8; i++)
+                {
+                    if (!XIMaskIsSet(deviceEvent->valuators.mask, i))
+                    {
+                        continue;
+                    }
+
+                    ScrollValuator *scroll = FindScrollValuator(deviceEvent->sourceid, i);
+                    if (scroll == nullptr)
+                    {
+                        moved = true;
+                    }
+                    else
+                    {
+                        if (scroll->valid)
+                        {
+                            double delta = (*value - scroll->last) / scroll->increment;
+                            (scroll->horizontal ? scrollX : scrollY) += delta;
+                        }
+                        scroll->last = *value;
+                        scroll->valid = true;
+                        scrolled = true;
+                    }
+                    value++;
+                }
+
+                if (scrollX != 0.0 || scrollY != 0.0)
+                {
+                    MouseScrollEvent scrollEvent;
+                    scrollEvent.deltaX = scrollX;
+                    // Valuators count down the page, deltaY counts up
+                    scrollEvent.deltaY = -scrollY;
+                    scrollEvent.precise = true;
+                    scrollEvent.serverTime = deviceEvent->time;
+                    scrollEvent.hostTime = hostTime;
+                    EmitEvent(source, scrollEvent);
+                }
+
+                if (moved || !scrolled)
+                {
+                    EmitPointerMotion(source, static_cast<int>(std::floor(deviceEvent->event_x)),
+                                      static_cast<int>(std::floor(deviceEvent->event_y)), deviceEvent->time, hostTime);
+                }
+            }
+            else if (event.xcookie.evtype == XI_ButtonPress || event.xcookie.evtype == XI_ButtonRelease)
+            {
+                XIDeviceEvent *deviceEvent = static_cast<XIDeviceEvent *>(event.xcookie.data);
+
+                // Devices with scroll valuators also send the wheel as emulated buttons 4 to 7, the
+                // valuators already reported it
+                bool emulatedScroll = (deviceEvent->flags & XIPointerEmulated) && deviceEvent->detail >= Button4 &&
+                                      deviceEvent->detail <= Button4 + 3;
+                if (!emulatedScroll)
+                {
+                    EmitButton(source, deviceEvent->detail, event.xcookie.evtype == XI_ButtonPress, deviceEvent->time, hostTime);
+                }
+            }
+            else if (event.xcookie.evtype == XI_Enter)
+            {
+                // Valuators kept counting while the pointer was over other windows
+                ResetScrollValuators();
+            }
+            else if (event.xcookie.evtype == XI_DeviceChanged)
+            {
+                XIDeviceChangedEvent *changed = static_cast<XIDeviceChangedEvent *>(event.xcookie.data);
+                LoadScrollValuators(changed->sourceid, changed->classes, changed->num_classes);
+            }
+
+            XFreeEventData(source, &event.xcookie);
+            break;
+        }
+#endif
+
+        case ClientMessage:
+        {
+            if (event.xclient.message_type != atoms.WM_PROTOCOLS)
+            {
+                break;
+            }
+
+            Atom protocol = static_cast<Atom>(event.xclient.data.l[0]);
+            if (protocol == atoms.WM_DELETE_WINDOW)
+            {
+                return false;
+            }
+
+            if (protocol == atoms.NET_WM_PING)
+            {
+                // Answer by sending the message back to the root window
+                XEvent reply = event;
+                reply.xclient.window = RootWindow(source, screen);
+                XSendEvent(source, reply.xclient.window, False,
+                           SubstructureNotifyMask | SubstructureRedirectMask, &reply);
+                XFlush(source);
+            }
+            break;
+        }
+
+        case MappingNotify:
+        {
+            XRefreshKeyboardMapping(&event.xmapping);
+
+            // Only the connection that receives key events owns the table
+            bool receivesKeys = inputThread.joinable() ? source == inputDisplay : source == display;
+            if (event.xmapping.request == MappingKeyboard && receivesKeys)
+            {
+                BuildKeycodeTable(source);
+            }
+            break;
+        }
+
+        case ConfigureNotify:
+        {
+            // Window coalesces bursts of these into one WindowResizeEvent per poll
+            WindowResizeEvent resizeEvent;
+            resizeEvent.width = event.xconfigure.width;
+            resizeEvent.height = event.xconfigure.height;
+            resizeEvent.hostTime = hostTime;
+            EmitEvent(source, resizeEvent);
+            break;
+        }
+        }
+
+        return true;
+    }
+
+    bool X11Backend::EnableDetectableAutoRepeat(Display *target)
+    {
+        // Per client setting, the input thread's connection has to enable it again
+        Bool supported = False;
+        XkbSetDetectableAutoRepeat(target, True, &supported);
+        if (!supported)
+        {
+            Flux::Info("XKB detectable auto-repeat not supported, matching repeat releases instead");
+        }
+        return supported;
+    }
+
+    void X11Backend::BuildKeycodeTable(Display *source)
+    {
+        keycodeTable.fill(Key::KEY_UNKNOWN);
+
+        int minKeycode, maxKeycode;
+        XDisplayKeycodes(source, &minKeycode, &maxKeycode);
+
+        int keysymsPerKeycode;
+        KeySym *keysyms = XGetKeyboardMapping(source, minKeycode, maxKeycode - minKeycode + 1, &keysymsPerKeycode);
+        if (keysyms == nullptr)
+        {
+            Flux::Error("Unable to read the keyboard mapping");
+            return;
+        }
+
+        for (int keycode = minKeycode; keycode <= maxKeycode; keycode++)
+        {
+            // Take the first level that names a known key, keypad digits only appear on the NumLock level
+            const KeySym *levels = keysyms + (keycode - minKeycode) * keysymsPerKeycode;
+            for (int level = 0; level < keysymsPerKeycode; level++)
+            {
+                Key key = X11KeySymToNovaKey(levels[level]);
+                if (key != Key::KEY_UNKNOWN)
+                {
+                    keycodeTable[keycode] = key;
+                    break;
+                }
+            }
+        }
+
+        XFree(keysyms);
+    }
+
+    void X11Backend::EmitPointerMotion(Display *source, int x, int y, Time time, std::chrono::steady_clock::time_point hostTime)
+    {
+        if (cursorLocked && rawMotion)
+        {
+            // Relative motion comes from XI_RawMotion instead
+            return;
+        }
+
+        if (cursorLocked)
+        {
+            int centerX = lockCenterX.load(std::memory_order_relaxed);
+            int centerY = lockCenterY.load(std::memory_order_relaxed);
+
+            int dx = x - centerX;
+            int dy = y - centerY;
+
+            if (dx != 0 || dy != 0)
+            {
+                // Push delta movement event
+                MouseMoveEvent mouseMoveEvent;
+                mouseMoveEvent.x = dx;
+                mouseMoveEvent.y = dy;
+                mouseMoveEvent.relative = true;
+                mouseMoveEvent.deltaX = dx;
+                mouseMoveEvent.deltaY = dy;
+                mouseMoveEvent.serverTime = time;
+                mouseMoveEvent.hostTime = hostTime;
+                EmitEvent(source, mouseMoveEvent);
+
+                // Warp back to center
+                XWarpPointer(source, None, window, 0, 0, 0, 0, centerX, centerY);
+                XFlush(source);
+            }
+        }
+        else
+        {
+            MouseMoveEvent mouseMoveEvent;
+            mouseMoveEvent.x = x;
+            mouseMoveEvent.y = y;
+            mouseMoveEvent.serverTime = time;
+            mouseMoveEvent.hostTime = hostTime;
+            EmitEvent(source, mouseMoveEvent);
+        }
+    }
+
+    void X11Backend::EmitButton(Display *source, unsigned int button, bool down, Time time,
+                                std::chrono::steady_clock::time_point hostTime)
+    {
+        MouseButton mouseButton;
+        switch (button)
+        {
+        case Button1:
+            mouseButton = MouseButton::Left;
+            break;
+        case Button2:
+            mouseButton = MouseButton::Middle;
+            break;
+        case Button3:
+            mouseButton = MouseButton::Right;
+            break;
+        case 8:
+            mouseButton = MouseButton::Back;
+            break;
+        case 9:
+            mouseButton = MouseButton::Forward;
+            break;
+
+        case Button4:
+        case Button5:
+        case Button4 + 2:
+        case Button4 + 3:
+        {
+            // Buttons 4 to 7 are wheel clicks up, down, left and right. Only the press counts, the
+            // server sends the release right after it.
+            if (!down)
+            {
+                return;
+            }
+
+            MouseScrollEvent scrollEvent;
+            scrollEvent.deltaY = button == Button4 ? 1.0 : button == Button5 ? -1.0 : 0.0;
+            scrollEvent.deltaX = button == Button4 + 2 ? -1.0 : button == Button4 + 3 ? 1.0 : 0.0;
+            scrollEvent.serverTime = time;
+            scrollEvent.hostTime = hostTime;
+            EmitEvent(source, scrollEvent);
+            return;
+        }
+
+        default:
+            return;
+        }
+
+        if (down)
+        {
+            MouseButtonDownEvent mouseDownEvent;
+            mouseDownEvent.button = mouseButton;
+            mouseDownEvent.serverTime = time;
+            mouseDownEvent.hostTime = hostTime;
+            EmitEvent(source, mouseDownEvent);
+        }
+        else
+        {
+            MouseButtonUpEvent mouseUpEvent;
+            mouseUpEvent.button = mouseButton;
+            mouseUpEvent.serverTime = time;
+            mouseUpEvent.hostTime = hostTime;
+            EmitEvent(source, mouseUpEvent);
+        }
+    }
+
+    void X11Backend::EmitEvent(Display *source, const Event &event)
+    {
+        // Events read on the input thread's connection are handed over to the render thread
+        if (source == inputDisplay)
+        {
+            if (!inputRing->Push(event))
+            {
+                inputDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+
+        owner.DispatchEvent(event);
+    }
+
+    void X11Backend::EmitText(Display *source, const char *text, size_t length, const XKeyEvent &key,
+                              std::chrono::steady_clock::time_point hostTime)
+    {
+        TextInputEvent textEvent;
+        textEvent.modifiers = ModifiersFromCoreMask(key.state);
+        textEvent.serverTime = key.time;
+        textEvent.hostTime = hostTime;
+
+        size_t i = 0;
+        while (i < length)
+        {
+            unsigned char lead = static_cast<unsigned char>(text[i]);
+            size_t size = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+            if (i + size > length)
+            {
+                break;
+            }
+
+            // Return, Backspace, Ctrl+letter and friends are key events, not text. Stray
+            // continuation bytes are dropped.
+            bool skip = lead < 0x20 || lead == 0x7F || (lead >= 0x80 && lead < 0xC0) ||
+                        (lead == 0xC2 && static_cast<unsigned char>(text[i + 1]) < 0xA0);
+            if (!skip)
+            {
+                if (textEvent.length + size > TextInputEvent::Capacity)
+                {
+                    EmitEvent(source, textEvent);
+                    textEvent.length = 0;
+                }
+
+                memcpy(textEvent.text + textEvent.length, text + i, size);
+                textEvent.length = static_cast<uint8_t>(textEvent.length + size);
+                textEvent.text[textEvent.length] = '\0';
+            }
+
+            i += (lead >= 0x80 && lead < 0xC0) ? 1 : size;
+        }
+
+        if (textEvent.length > 0)
+        {
+            EmitEvent(source, textEvent);
+        }
+    }
+
+    void X11Backend::SetResizable(bool resizable)
+    {
+        XSizeHints size_hints;
+        if (resizable)
+        {
+            size_hints.flags = PMinSize;
+            size_hints.min_width = 1;
+            size_hints.min_height = 1;
+        }
+        else
+        {
+            size_hints.flags = PMinSize | PMaxSize;
+            size_hints.min_width = size_hints.max_width = owner.width;
+            size_hints.min_height = size_hints.max_height = owner.height;
+        }
+
+        XSetWMNormalHints(display, window, &size_hints);
+        XFlush(display);
+    }
+
+    SoftwareSurface X11Backend::AcquireSurface()
+    {
+        // Buffers have the size of the window at the time they were created
+        if (framebuffer && (framebuffer->GetWidth() != owner.width || framebuffer->GetHeight() != owner.height))
+        {
+            framebuffer.reset();
+        }
+
+        if (!framebuffer)
+        {
+            framebuffer = std::make_unique<X11Framebuffer>(display, window, owner.width, owner.height);
+            if (!framebuffer->Create())
+            {
+                framebuffer.reset();
+                return SoftwareSurface();
+            }
+        }
+
+        return framebuffer->Acquire();
+    }
+
+    void X11Backend::Present()
+    {
+        if (framebuffer)
+        {
+            framebuffer->Present();
+        }
+    }
+
+    bool X11Backend::HasPendingInput()
+    {
+        if (context != nullptr)
+        {
+            // XPending counts the events of every window on the shared connection, so they are routed
+            // first and only this window's share counts
+            context->Pump();
+            return !sharedEvents->Empty();
+        }
+
+        return (inputRing && !inputRing->Empty()) || XPending(display) > 0;
+    }
+
+    void X11Backend::WaitForInput(const struct timespec *timeout, int wakeFd, int deviceFd)
+    {
+        // XPending has flushed the output buffer and found Xlib's queue empty, so it is safe to
+        // sleep on the socket until the server sends something
+        struct pollfd fds[3];
+        fds[0].fd = ConnectionNumber(display);
+        fds[0].events = POLLIN;
+        fds[1].fd = wakeFd;
+        fds[1].events = POLLIN;
+        fds[2].fd = deviceFd;
+        fds[2].events = POLLIN;
+
+        auto deadline = std::chrono::steady_clock::time_point::max();
+        if (timeout != nullptr)
+        {
+            deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout->tv_sec) +
+                       std::chrono::nanoseconds(timeout->tv_nsec);
+        }
+
+        // A shared connection also wakes for the other windows of the context. Their events are
+        // routed and the wait goes on until this window has some, a wake-up or the timeout.
+        for (;;)
+        {
+            struct timespec remaining;
+            if (timeout != nullptr)
+            {
+                auto left = std::max(deadline - std::chrono::steady_clock::now(), std::chrono::steady_clock::duration::zero());
+                auto seconds = std::chrono::duration_cast<std::chrono::seconds>(left);
+                remaining.tv_sec = seconds.count();
+                remaining.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(left - seconds).count();
+            }
+
+            fds[0].revents = 0;
+            fds[1].revents = 0;
+            fds[2].revents = 0;
+
+            // ppoll skips negative descriptors, so a missing eventfd or device set needs no special case
+            if (ppoll(fds, 3, timeout != nullptr ? &remaining : nullptr, nullptr) < 0 && errno != EINTR)
+            {
+                Flux::Error("Waiting for events failed: {}", errno);
+                return;
+            }
+
+            if (fds[1].revents & POLLIN)
+            {
+                uint64_t value;
+                ssize_t result = read(wakeFd, &value, sizeof(value));
+                (void)result;
+                return;
+            }
+
+            if (context == nullptr || (fds[2].revents & POLLIN) || std::chrono::steady_clock::now() >= deadline)
+            {
+                return;
+            }
+
+            context->Pump();
+            if (!sharedEvents->Empty())
+            {
+                return;
+            }
+        }
+    }
+
+    void X11Backend::LockCursor()
+    {
+        if (cursorLocked)
+        {
+            return;
+        }
+
+        // The grab and the raw motion selection belong to the connection, a shared one has a single
+        // window holding them
+        if (context != nullptr)
+        {
+            if (context->lockOwner != nullptr)
+            {
+                context->lockOwner->UnlockCursor();
+            }
+            context->lockOwner = this;
+        }
+
+        // Create invisible cursor
+        Pixmap bm_no;
+        XColor black;
+        static char no_data[] = { 0,0,0,0,0,0,0,0 };
+        black.red = black.green = black.blue = 0;
+        bm_no = XCreateBitmapFromData(display, window, no_data, 8, 8);
+        invisibleCursor = XCreatePixmapCursor(display, bm_no, bm_no, &black, &black, 0, 0);
+        XDefineCursor(display, window, invisibleCursor);
+        XFreePixmap(display, bm_no);
+        XFlush(display);
+
+        SetLockCenter(owner.width, owner.height);
+        cursorLocked = true;
+
+        // The grab belongs to whichever connection receives input
+        if (inputThread.joinable())
+        {
+            RequestCursorGrab(CursorRequest::Grab);
+        }
+        else
+        {
+            GrabCursor(display, true);
+        }
+    }
+
+    void X11Backend::UnlockCursor()
+    {
+        if (!cursorLocked)
+        {
+            return;
+        }
+
+        if (inputThread.joinable())
+        {
+            RequestCursorGrab(CursorRequest::Ungrab);
+        }
+        else
+        {
+            GrabCursor(display, false);
+        }
+
+        XUndefineCursor(display, window);
+        XFreeCursor(display, invisibleCursor);
+        XFlush(display);
+
+        cursorLocked = false;
+        if (context != nullptr && context->lockOwner == this)
+        {
+            context->lockOwner = nullptr;
+        }
+    }
+
+    void X11Backend::SetLockCenter(int width, int height)
+    {
+        lockCenterX.store(width / 2, std::memory_order_relaxed);
+        lockCenterY.store(height / 2, std::memory_order_relaxed);
+    }
+
+    void X11Backend::GrabCursor(Display *target, bool grab)
+    {
+        if (!grab)
+        {
+            if (rawMotion)
+            {
+                SelectRawMotion(target, false);
+                rawMotion = false;
+            }
+
+            XUngrabPointer(target, CurrentTime);
+            XFlush(target);
+            return;
+        }
+
+        rawMotion = SelectRawMotion(target, true);
+        rawRemainderX = 0.0;
+        rawRemainderY = 0.0;
+
+        // Grab pointer, with raw motion the core motion events are not needed at all
+        if (rawMotion)
+        {
+            XGrabPointer(target, window, False,
+                        ButtonPressMask | ButtonReleaseMask,
+                        GrabModeAsync, GrabModeAsync, window, None, CurrentTime);
+        }
+        else
+        {
+            XGrabPointer(target, window, True,
+                        PointerMotionMask | ButtonPressMask | ButtonReleaseMask,
+                        GrabModeAsync, GrabModeAsync, window, None, CurrentTime);
+        }
+
+        // Move to center
+        int centerX = lockCenterX.load(std::memory_order_relaxed);
+        int centerY = lockCenterY.load(std::memory_order_relaxed);
+        XWarpPointer(target, None, window, 0, 0, 0, 0, centerX, centerY);
+        XFlush(target);
+    }
+
+    void X11Backend::RequestCursorGrab(CursorRequest request)
+    {
+        cursorRequest.store(request, std::memory_order_release);
+
+        uint64_t value = 1;
+        ssize_t written = write(inputWakeFd, &value, sizeof(value));
+        (void)written;
+    }
+
+    bool X11Backend::SelectRawMotion(Display *target, bool enable)
+    {
+#ifdef NOVA_HAS_XINPUT2
+        if (xiOpcode == -1)
+        {
+            return false;
+        }
+
+        // Raw events are only delivered to the root window
+        unsigned char mask[XIMaskLen(XI_RawMotion)] = { 0 };
+        if (enable)
+        {
+            XISetMask(mask, XI_RawMotion);
+        }
+
+        XIEventMask eventMask;
+        eventMask.deviceid = XIAllMasterDevices;
+        eventMask.mask_len = sizeof(mask);
+        eventMask.mask = mask;
+
+        XISelectEvents(target, RootWindow(target, screen), &eventMask, 1);
+        return enable;
+#else
+        (void)target;
+        (void)enable;
+        return false;
+#endif
+    }
+
+    bool X11Backend::SelectPointerEvents(Display *target, bool enable)
+    {
+#ifdef NOVA_HAS_XINPUT2
+        if (xiOpcode == -1)
+        {
+            return false;
+        }
+
+        // Replaces the core pointer events on the window, and like them button presses can only be
+        // selected by one connection
+        unsigned char mask[XIMaskLen(XI_Enter)] = { 0 };
+        if (enable)
+        {
+            XISetMask(mask, XI_DeviceChanged);
+            XISetMask(mask, XI_ButtonPress);
+            XISetMask(mask, XI_ButtonRelease);
+            XISetMask(mask, XI_Motion);
+            XISetMask(mask, XI_Enter);
+        }
+
+        XIEventMask eventMask;
+        eventMask.deviceid = XIAllMasterDevices;
+        eventMask.mask_len = sizeof(mask);
+        eventMask.mask = mask;
+
+        XISelectEvents(target, window, &eventMask, 1);
+        if (!enable)
+        {
+            return false;
+        }
+
+        // Master events name the slave that caused them in sourceid, so the table is per slave
+        scrollValuatorCount = 0;
+        int deviceCount = 0;
+        XIDeviceInfo *devices = XIQueryDevice(target, XIAllDevices, &deviceCount);
+        for (int i = 0; i < deviceCount; i++)
+        {
+            if (devices[i].use == XISlavePointer)
+            {
+                LoadScrollValuators(devices[i].deviceid, devices[i].classes, devices[i].num_classes);
+            }
+        }
+        XIFreeDeviceInfo(devices);
+        return true;
+#else
+        (void)target;
+        (void)enable;
+        return false;
+#endif
+    }
+
+#ifdef NOVA_HAS_XINPUT2
+    void X11Backend::LoadScrollValuators(int deviceid, XIAnyClassInfo **classes, int count)
+    {
+        // Drop what is known about the device, its classes are replaced as a whole
+        int kept = 0;
+        for (int i = 0; i < scrollValuatorCount; i++)
+        {
+            if (scrollValuators[i].deviceid != deviceid)
+            {
+                scrollValuators[kept++] = scrollValuators[i];
+            }
+        }
+        scrollValuatorCount = kept;
+
+        for (int i = 0; i < count && scrollValuatorCount < MaxScrollValuators; i++)
+        {
+            if (classes[i]->type != XIScrollClass)
+            {
+                continue;
+            }
+
+            XIScrollClassInfo *info = reinterpret_cast<XIScrollClassInfo *>(classes[i]);
+            ScrollValuator &scroll = scrollValuators[scrollValuatorCount++];
+            scroll = ScrollValuator();
+            scroll.deviceid = deviceid;
+            scroll.number = info->number;
+            scroll.horizontal = info->scroll_type == XIScrollTypeHorizontal;
+            scroll.increment = info->increment != 0.0 ? info->increment : 1.0;
+        }
+    }
+#endif
+
+    X11Backend::ScrollValuator *X11Backend::FindScrollValuator(int deviceid, int number)
+    {
+        for (int i = 0; i < scrollValuatorCount; i++)
+        {
+            if (scrollValuators[i].deviceid == deviceid && scrollValuators[i].number == number)
+            {
+                return &scrollValuators[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void X11Backend::ResetScrollValuators()
+    {
+        for (int i = 0; i < scrollValuatorCount; i++)
+        {
+            scrollValuators[i].valid = false;
+        }
+    }
+
+    bool X11Backend::StartInputThread()
+    {
+        if (inputThread.joinable())
+        {
+            return true;
+        }
+
+        if (context != nullptr)
+        {
+            // The context's pump would race the thread for this window's events
+            Flux::Error("Input thread is not supported for windows on a DisplayContext");
+            return false;
+        }
+
+        // A second connection, so the input thread never shares Xlib state with the render thread
+        inputDisplay = XOpenDisplay(DisplayString(display));
+        if (inputDisplay == nullptr)
+        {
+            Flux::Error("Unable to open input thread X display");
+            return false;
+        }
+
+        inputWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (inputWakeFd == -1)
+        {
+            Flux::Error("Unable to create input thread eventfd");
+            XCloseDisplay(inputDisplay);
+            inputDisplay = nullptr;
+            return false;
+        }
+
+        inputRing = std::make_unique<SpscRing<Event>>(Window::EventQueueCapacity);
+
+        if (cursorLocked)
+        {
+            GrabCursor(display, false);
+        }
+
+        // Button presses can only be selected by one client, so release them before the input
+        // connection selects them
+        XSelectInput(display, window, WindowEventMask);
+        if (smoothScroll)
+        {
+            SelectPointerEvents(display, false);
+        }
+        XSync(display, False);
+        long threadTextInputEventMask = inputThreadTextInput.Open(inputDisplay, window);
+        XSelectInput(inputDisplay, window, InputEventMask | threadTextInputEventMask);
+#ifdef NOVA_HAS_XINPUT2
+        if (xiOpcode != -1)
+        {
+            // XI2 requests are only accepted after the connection announced its version
+            int major = 2;
+            int minor = 1;
+            XIQueryVersion(inputDisplay, &major, &minor);
+        }
+#endif
+        if (smoothScroll)
+        {
+            SelectPointerEvents(inputDisplay, true);
+        }
+        EnableDetectableAutoRepeat(inputDisplay);
+        XFlush(inputDisplay);
+
+        if (cursorLocked)
+        {
+            cursorRequest.store(CursorRequest::Grab, std::memory_order_relaxed);
+        }
+
+        inputThreadStop.store(false, std::memory_order_relaxed);
+        inputThread = std::thread(&X11Backend::InputThreadMain, this);
+        return true;
+    }
+
+    void X11Backend::StopInputThread()
+    {
+        if (!inputThread.joinable())
+        {
+            return;
+        }
+
+        inputThreadStop.store(true, std::memory_order_release);
+        uint64_t value = 1;
+        ssize_t written = write(inputWakeFd, &value, sizeof(value));
+        (void)written;
+        inputThread.join();
+
+        // Closing the connection drops its selections and grabs, input moves back to the main connection
+        if (rawMotion)
+        {
+            SelectRawMotion(inputDisplay, false);
+            rawMotion = false;
+        }
+        inputThreadTextInput.Close();
+        XCloseDisplay(inputDisplay);
+        inputDisplay = nullptr;
+
+        XSelectInput(display, window, WindowEventMask | InputEventMask | textInputEventMask);
+        if (smoothScroll)
+        {
+            SelectPointerEvents(display, true);
+        }
+        if (cursorLocked)
+        {
+            GrabCursor(display, true);
+        }
+        XFlush(display);
+
+        // Keep whatever the thread translated before it stopped
+        Event event;
+        while (inputRing->Pop(event))
+        {
+            owner.DispatchEvent(event);
+        }
+        inputRing.reset();
+
+        close(inputWakeFd);
+        inputWakeFd = -1;
+    }
+
+    void X11Backend::InputThreadMain()
+    {
+        while (!inputThreadStop.load(std::memory_order_acquire))
+        {
+            CursorRequest request = cursorRequest.exchange(CursorRequest::Idle, std::memory_order_acquire);
+            if (request != CursorRequest::Idle)
+            {
+                GrabCursor(inputDisplay, request == CursorRequest::Grab);
+            }
+
+            bool published = false;
+            while (XPending(inputDisplay) > 0)
+            {
+                XEvent event;
+                XNextEvent(inputDisplay, &event);
+                ProcessXEvent(inputDisplay, event, std::chrono::steady_clock::now());
+                published = true;
+            }
+
+            if (published)
+            {
+                // Wake the render thread if it is blocked in WaitEvents
+                owner.PostEmptyEvent();
+            }
+
+            // XPending flushed the output buffer, sleep until the server or the render thread has something
+            struct pollfd fds[2];
+            fds[0].fd = ConnectionNumber(inputDisplay);
+            fds[0].events = POLLIN;
+            fds[0].revents = 0;
+            fds[1].fd = inputWakeFd;
+            fds[1].events = POLLIN;
+            fds[1].revents = 0;
+
+            if (poll(fds, 2, -1) > 0 && (fds[1].revents & POLLIN))
+            {
+                uint64_t value;
+                ssize_t result = read(inputWakeFd, &value, sizeof(value));
+                (void)result;
+            }
+        }
+    }
+}
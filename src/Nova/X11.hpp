@@ -0,0 +1,251 @@
+#pragma once
+#include <Nova/Event.hpp>
+#include <Nova/EventQueue.hpp>
+#include <Nova/X11Framebuffer.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#ifdef NOVA_HAS_XINPUT2
+#include <X11/extensions/XInput2.h>
+#endif
+
+using X11Window = ::Window;
+
+namespace Nova
+{
+    class Window;
+    class DisplayContext;
+
+    /// @brief Only used to build keycode tables, key events are translated with a table lookup
+    Key X11KeySymToNovaKey(KeySym keysym);
+
+    /// @brief Every atom Nova uses, interned once per display in a single XInternAtoms round trip
+    /// so no event path has to wait on the server
+    class X11Atoms
+    {
+    public:
+        Atom WM_PROTOCOLS = 0;
+        Atom WM_DELETE_WINDOW = 0;
+        Atom NET_WM_PING = 0;
+        Atom NET_WM_STATE = 0;
+        Atom NET_WM_STATE_FULLSCREEN = 0;
+        Atom NET_WM_STATE_MAXIMIZED_VERT = 0;
+        Atom NET_WM_STATE_MAXIMIZED_HORZ = 0;
+        Atom NET_WM_STATE_ABOVE = 0;
+        Atom NET_WM_STATE_HIDDEN = 0;
+        Atom NET_WM_BYPASS_COMPOSITOR = 0;
+        Atom CLIPBOARD = 0;
+        Atom UTF8_STRING = 0;
+
+        /// @brief Interns all atoms, returns false if the request failed
+        bool Load(Display *display);
+    };
+
+    /// @brief XIM input method and input context of one connection, turns key presses into UTF-8
+    /// through Xutf8LookupString so layouts, dead keys, compose and input method servers work
+    class X11TextInput
+    {
+    private:
+        XIM method = nullptr;
+        XIC context = nullptr;
+
+        // Input method servers send a press back to the client after filtering it, the copy has the
+        // same timestamp as the original and must not become a second key event
+        std::array<Time, 256> pressTimes{};
+
+    public:
+        X11TextInput() = default;
+        ~X11TextInput();
+
+        X11TextInput(const X11TextInput &) = delete;
+        X11TextInput &operator=(const X11TextInput &) = delete;
+
+        /// @brief Opens the input method for display and binds a context to window. Returns the extra
+        /// events the input method needs selected, 0 if no input method is available.
+        long Open(Display *display, X11Window window);
+        void Close();
+
+        /// @brief Passes every event to the input method first, true if it consumed the event
+        bool Filter(XEvent &event);
+
+        /// @brief True for a press that already produced a key event
+        bool IsDuplicatePress(unsigned int keycode, Time time);
+
+        void SetFocus(bool focused);
+
+        /// @brief UTF-8 typed by a press, stored in buffer and null terminated. Falls back to the
+        /// Latin-1 and Unicode keysyms when no input method could be opened. Returns the length.
+        size_t Lookup(XKeyEvent &event, char *buffer, size_t size);
+    };
+
+    /// @brief X event read by a DisplayContext for one of its windows, with the time it was read
+    class X11RoutedEvent
+    {
+    public:
+        XEvent event;
+        std::chrono::steady_clock::time_point hostTime;
+    };
+
+    /// @brief Xlib window. X events are translated straight into the owning Window's event queue,
+    /// optionally on a dedicated input thread.
+    class X11Backend
+    {
+    private:
+        friend class DisplayContext;
+
+        Window &owner;
+
+        Display *display = nullptr;
+        X11Window window = 0;
+        int screen = 0;
+
+        X11Atoms atoms;
+
+        // Set for windows on a DisplayContext. The context owns the connection and routes this
+        // window's events into sharedEvents, PollEvents translates them from there.
+        DisplayContext *context = nullptr;
+        std::unique_ptr<RingBuffer<X11RoutedEvent>> sharedEvents;
+
+        bool CreateWindow(const std::string &title, int width, int height);
+
+        // Created on first use of the software surface
+        std::unique_ptr<X11Framebuffer> framebuffer;
+
+        std::atomic<bool> cursorLocked{false};
+        Cursor invisibleCursor = 0;
+
+        // Window centre the pointer is warped back to while locked. Written by the render thread,
+        // read by the input thread, which must not touch owner.width/height.
+        std::atomic<int> lockCenterX{0};
+        std::atomic<int> lockCenterY{0};
+
+        // XInput2 raw motion, used for LockCursor instead of warping the pointer when available
+        int xiOpcode = -1;
+        bool rawMotion = false;
+        double rawRemainderX = 0.0;
+        double rawRemainderY = 0.0;
+
+        bool SelectRawMotion(Display *target, bool enable);
+
+        // XInput 2.1 smooth scrolling. Pointer events then come from XI2 instead of the core
+        // protocol, and scroll valuators of every slave pointer turn into fractional scroll deltas.
+        class ScrollValuator
+        {
+        public:
+            int deviceid = 0;
+            int number = 0;
+            bool horizontal = false;
+            double increment = 1.0;
+            // Absolute value at the last event, only meaningful while valid is set
+            double last = 0.0;
+            bool valid = false;
+        };
+
+        static constexpr int MaxScrollValuators = 16;
+
+        bool smoothScroll = false;
+        std::array<ScrollValuator, MaxScrollValuators> scrollValuators{};
+        int scrollValuatorCount = 0;
+
+        bool SelectPointerEvents(Display *target, bool enable);
+#ifdef NOVA_HAS_XINPUT2
+        void LoadScrollValuators(int deviceid, XIAnyClassInfo **classes, int count);
+#endif
+        ScrollValuator *FindScrollValuator(int deviceid, int number);
+        void ResetScrollValuators();
+
+        // Hardware keycode to Key, built from the keyboard mapping so key events need no keysym lookup
+        std::array<Key, 256> keycodeTable{};
+
+        void BuildKeycodeTable(Display *source);
+
+        // With XKB detectable auto-repeat the server sends no release between repeated presses,
+        // otherwise releases have to be matched against the next queued press
+        bool detectableAutoRepeat = false;
+
+        bool EnableDetectableAutoRepeat(Display *target);
+
+        // Text input on the main connection, and on the input thread's connection while it runs
+        X11TextInput textInput;
+        X11TextInput inputThreadTextInput;
+        long textInputEventMask = 0;
+
+        X11TextInput &TextInputFor(Display *source) { return source == inputDisplay ? inputThreadTextInput : textInput; }
+        void EmitText(Display *source, const char *text, size_t length, const XKeyEvent &key,
+                      std::chrono::steady_clock::time_point hostTime);
+
+        // Optional input thread, it reads and translates input on its own connection and hands
+        // events to the render thread through inputRing
+        enum class CursorRequest
+        {
+            Idle,
+            Grab,
+            Ungrab
+        };
+
+        Display *inputDisplay = nullptr;
+        int inputWakeFd = -1;
+        std::thread inputThread;
+        std::atomic<bool> inputThreadStop{false};
+        std::atomic<CursorRequest> cursorRequest{CursorRequest::Idle};
+        std::unique_ptr<SpscRing<Event>> inputRing;
+        std::atomic<size_t> inputDroppedEvents{0};
+
+        void InputThreadMain();
+        void GrabCursor(Display *target, bool grab);
+        void RequestCursorGrab(CursorRequest request);
+
+        bool ProcessXEvent(Display *source, XEvent &event, std::chrono::steady_clock::time_point hostTime);
+        void EmitPointerMotion(Display *source, int x, int y, Time time, std::chrono::steady_clock::time_point hostTime);
+        void EmitButton(Display *source, unsigned int button, bool down, Time time, std::chrono::steady_clock::time_point hostTime);
+        void EmitEvent(Display *source, const Event &event);
+
+    public:
+        explicit X11Backend(Window &owner);
+        ~X11Backend();
+
+        X11Backend(const X11Backend &) = delete;
+        X11Backend &operator=(const X11Backend &) = delete;
+
+        /// @brief Opens the display and maps the window, returns false if no X server is reachable
+        bool Create(const std::string &title, int width, int height);
+
+        /// @brief Maps the window on the context's connection, returns false if the context has no display
+        bool Create(DisplayContext &context, const std::string &title, int width, int height);
+
+        /// @brief Translates every pending X event, returns false once the window was closed
+        bool PollEvents();
+
+        /// @brief True if Xlib or the input thread already hold events that PollEvents would translate
+        /// @brief True if this window has events to translate. On a DisplayContext the connection is
+        /// pumped first and only the events routed to this window count.
+        bool HasPendingInput();
+
+        /// @brief Sleeps until the server sends something, wakeFd becomes readable or the timeout passes.
+        /// On a DisplayContext events for the other windows are routed without ending the wait.
+        void WaitForInput(const struct timespec *timeout, int wakeFd, int deviceFd);
+
+        void LockCursor();
+        void UnlockCursor();
+
+        /// @brief Called by Window whenever its size changes, keeps the locked cursor centred
+        void SetLockCenter(int width, int height);
+
+        bool StartInputThread();
+        void StopInputThread();
+
+        void SetResizable(bool resizable);
+
+        SoftwareSurface AcquireSurface();
+        void Present();
+
+        Display *GetDisplay() const { return display; }
+        X11Window GetWindow() const { return window; }
+    };
+}
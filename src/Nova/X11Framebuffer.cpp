@@ -0,0 +1,246 @@
+#include <Nova/X11Framebuffer.hpp>
+#include <Flux/Flux.hpp>
+#include <cstdlib>
+
+namespace Nova
+{
+#ifdef NOVA_HAS_XSHM
+    // XShmAttach only fails asynchronously, e.g. on a remote display, so the error is caught here
+    static bool shmAttachFailed = false;
+
+    static int HandleShmAttachError(Display *, XErrorEvent *)
+    {
+        shmAttachFailed = true;
+        return 0;
+    }
+#endif
+
+    X11Framebuffer::X11Framebuffer(Display *display, X11Window window, int width, int height)
+        : display(display), window(window), width(width), height(height)
+    {
+    }
+
+    X11Framebuffer::~X11Framebuffer()
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            WaitForCompletion(i);
+            DestroyImage(i);
+        }
+
+        if (gc != nullptr)
+        {
+            XFreeGC(display, gc);
+        }
+    }
+
+    bool X11Framebuffer::Create()
+    {
+        int screen = DefaultScreen(display);
+        int depth = DefaultDepth(display, screen);
+        if (depth != 24 && depth != 32)
+        {
+            Flux::Error("Software surfaces need a 24 or 32 bit visual, the default visual has {} bits", depth);
+            return false;
+        }
+
+        gc = XCreateGC(display, window, 0, nullptr);
+
+#ifdef NOVA_HAS_XSHM
+        if (XShmQueryExtension(display))
+        {
+            completionEvent = XShmGetEventBase(display) + ShmCompletion;
+            useShm = CreateShmImage(0) && CreateShmImage(1);
+            if (!useShm)
+            {
+                DestroyImage(0);
+                DestroyImage(1);
+            }
+        }
+#endif
+
+        if (!useShm)
+        {
+            Flux::Info("MIT-SHM unavailable, software surfaces will be copied over the connection");
+            if (!CreatePlainImage(0) || !CreatePlainImage(1))
+            {
+                return false;
+            }
+        }
+
+        if (images[0]->bits_per_pixel != 32)
+        {
+            Flux::Error("Software surfaces need 32 bits per pixel, the server uses {}", images[0]->bits_per_pixel);
+            return false;
+        }
+
+        return true;
+    }
+
+#ifdef NOVA_HAS_XSHM
+    bool X11Framebuffer::CreateShmImage(int index)
+    {
+        int screen = DefaultScreen(display);
+        XShmSegmentInfo &segment = segments[index];
+
+        images[index] = XShmCreateImage(display, DefaultVisual(display, screen), DefaultDepth(display, screen),
+                                        ZPixmap, nullptr, &segment, width, height);
+        if (images[index] == nullptr)
+        {
+            return false;
+        }
+
+        segment.shmid = shmget(IPC_PRIVATE, images[index]->bytes_per_line * images[index]->height, IPC_CREAT | 0600);
+        if (segment.shmid == -1)
+        {
+            return false;
+        }
+
+        segment.shmaddr = images[index]->data = static_cast<char *>(shmat(segment.shmid, nullptr, 0));
+        segment.readOnly = False;
+        if (segment.shmaddr == reinterpret_cast<char *>(-1))
+        {
+            segment.shmaddr = images[index]->data = nullptr;
+            shmctl(segment.shmid, IPC_RMID, nullptr);
+            segment.shmid = -1;
+            return false;
+        }
+
+        shmAttachFailed = false;
+        XErrorHandler previousHandler = XSetErrorHandler(HandleShmAttachError);
+        XShmAttach(display, &segment);
+        XSync(display, False);
+        XSetErrorHandler(previousHandler);
+
+        // Removed once both sides have detached, so a crash can't leak the segment
+        shmctl(segment.shmid, IPC_RMID, nullptr);
+
+        if (shmAttachFailed)
+        {
+            shmdt(segment.shmaddr);
+            segment.shmaddr = images[index]->data = nullptr;
+            segment.shmid = -1;
+            return false;
+        }
+
+        return true;
+    }
+
+    Bool X11Framebuffer::IsCompletion(Display *, XEvent *event, XPointer arg)
+    {
+        // Windows of a DisplayContext share the connection, completions for another window's
+        // buffers have to stay queued for it
+        X11Framebuffer *framebuffer = reinterpret_cast<X11Framebuffer *>(arg);
+        return event->type == framebuffer->completionEvent &&
+               reinterpret_cast<XShmCompletionEvent *>(event)->drawable == framebuffer->window;
+    }
+#endif
+
+    bool X11Framebuffer::CreatePlainImage(int index)
+    {
+        int screen = DefaultScreen(display);
+
+        images[index] = XCreateImage(display, DefaultVisual(display, screen), DefaultDepth(display, screen),
+                                     ZPixmap, 0, nullptr, width, height, 32, 0);
+        if (images[index] == nullptr)
+        {
+            return false;
+        }
+
+        // XDestroyImage frees this with free()
+        images[index]->data = static_cast<char *>(calloc(images[index]->bytes_per_line, images[index]->height));
+        return images[index]->data != nullptr;
+    }
+
+    void X11Framebuffer::DestroyImage(int index)
+    {
+        if (images[index] == nullptr)
+        {
+            return;
+        }
+
+#ifdef NOVA_HAS_XSHM
+        if (segments[index].shmaddr != nullptr)
+        {
+            XShmDetach(display, &segments[index]);
+            shmdt(segments[index].shmaddr);
+            segments[index] = XShmSegmentInfo();
+
+            // The data belongs to the segment, not to the image
+            images[index]->data = nullptr;
+        }
+#endif
+
+        XDestroyImage(images[index]);
+        images[index] = nullptr;
+    }
+
+    void X11Framebuffer::WaitForCompletion(int index)
+    {
+#ifdef NOVA_HAS_XSHM
+        while (busy[index])
+        {
+            // Only takes completion events out of the queue, everything else stays in order for PollEvents
+            XEvent event;
+            XIfEvent(display, &event, IsCompletion, reinterpret_cast<XPointer>(this));
+            HandleEvent(event);
+        }
+#else
+        (void)index;
+#endif
+    }
+
+    SoftwareSurface X11Framebuffer::Acquire()
+    {
+        WaitForCompletion(back);
+
+        SoftwareSurface surface;
+        surface.pixels = reinterpret_cast<uint32_t *>(images[back]->data);
+        surface.width = width;
+        surface.height = height;
+        surface.stride = images[back]->bytes_per_line / 4;
+        return surface;
+    }
+
+    void X11Framebuffer::Present()
+    {
+#ifdef NOVA_HAS_XSHM
+        if (useShm)
+        {
+            // The server reads the pixels from shared memory and reports ShmCompletion once done
+            XShmPutImage(display, window, gc, images[back], 0, 0, 0, 0, width, height, True);
+            busy[back] = true;
+        }
+        else
+#endif
+        {
+            XPutImage(display, window, gc, images[back], 0, 0, 0, 0, width, height);
+        }
+
+        XFlush(display);
+        back ^= 1;
+    }
+
+    bool X11Framebuffer::HandleEvent(const XEvent &event)
+    {
+#ifdef NOVA_HAS_XSHM
+        if (event.type != completionEvent || !useShm)
+        {
+            return false;
+        }
+
+        const XShmCompletionEvent &completion = reinterpret_cast<const XShmCompletionEvent &>(event);
+        for (int i = 0; i < 2; i++)
+        {
+            if (segments[i].shmseg == completion.shmseg)
+            {
+                busy[i] = false;
+            }
+        }
+        return true;
+#else
+        (void)event;
+        return false;
+#endif
+    }
+}
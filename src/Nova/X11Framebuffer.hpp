@@ -0,0 +1,68 @@
+#pragma once
+#include <Nova/SoftwareSurface.hpp>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#ifdef NOVA_HAS_XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#endif
+
+using X11Window = ::Window;
+
+namespace Nova
+{
+    /// @brief Double buffered XImages for software rendering. With MIT-SHM the server reads the
+    /// pixels straight from shared memory, otherwise every Present copies them over the socket.
+    class X11Framebuffer
+    {
+    private:
+        Display *display;
+        X11Window window;
+        GC gc = nullptr;
+        int width;
+        int height;
+
+        XImage *images[2] = {};
+        // Set while the server may still read a buffer, cleared by its ShmCompletion event
+        bool busy[2] = {};
+        int back = 0;
+
+        bool useShm = false;
+        int completionEvent = -1;
+
+#ifdef NOVA_HAS_XSHM
+        XShmSegmentInfo segments[2] = {};
+
+        bool CreateShmImage(int index);
+        static Bool IsCompletion(Display *display, XEvent *event, XPointer arg);
+#endif
+
+        bool CreatePlainImage(int index);
+        void DestroyImage(int index);
+        void WaitForCompletion(int index);
+
+    public:
+        X11Framebuffer(Display *display, X11Window window, int width, int height);
+        ~X11Framebuffer();
+
+        X11Framebuffer(const X11Framebuffer &) = delete;
+        X11Framebuffer &operator=(const X11Framebuffer &) = delete;
+
+        /// @brief Creates both buffers, returns false if the visual has no 32 bit pixel format
+        bool Create();
+
+        /// @brief The buffer to draw the next frame into, waits until the server has released it
+        SoftwareSurface Acquire();
+
+        /// @brief Shows the buffer returned by the last Acquire and swaps buffers
+        void Present();
+
+        /// @brief Consumes ShmCompletion events, returns true if the event was one
+        bool HandleEvent(const XEvent &event);
+
+        int GetWidth() const { return width; }
+        int GetHeight() const { return height; }
+    };
+}
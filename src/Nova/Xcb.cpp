@@ -0,0 +1,605 @@
+#include <Nova/Nova.hpp>
+#include <Nova/Xcb.hpp>
+#include <Flux/Flux.hpp>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <xcb/xcbext.h>
+
+namespace Nova
+{
+    static constexpr uint32_t XcbEventMask = XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_STRUCTURE_NOTIFY |
+                                             XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE |
+                                             XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE |
+                                             XCB_EVENT_MASK_POINTER_MOTION;
+
+    // ICCCM WM_SIZE_HINTS flags
+    static constexpr uint32_t SizeHintMinSize = 1 << 4;
+    static constexpr uint32_t SizeHintMaxSize = 1 << 5;
+
+    XcbBackend::XcbBackend(Window &owner)
+        : owner(owner)
+    {
+        batch.reserve(256);
+    }
+
+    XcbBackend::~XcbBackend()
+    {
+        if (connection == nullptr)
+        {
+            return;
+        }
+
+        if (window != 0)
+        {
+            UnlockCursor();
+            xcb_destroy_window(connection, window);
+        }
+
+        free(heldEvent);
+        xcb_disconnect(connection);
+    }
+
+    bool XcbBackend::Create(const std::string &title, int width, int height)
+    {
+        int screenNumber = 0;
+        connection = xcb_connect(nullptr, &screenNumber);
+        if (xcb_connection_has_error(connection))
+        {
+            xcb_disconnect(connection);
+            connection = nullptr;
+            return false;
+        }
+
+        xcb_screen_iterator_t screens = xcb_setup_roots_iterator(xcb_get_setup(connection));
+        for (int i = 0; i < screenNumber; i++)
+        {
+            xcb_screen_next(&screens);
+        }
+        screen = screens.data;
+
+        // Everything that needs a reply is sent first, the replies are collected together below
+        static const char *atomNames[] = { "WM_PROTOCOLS", "WM_DELETE_WINDOW", "_NET_WM_PING" };
+        xcb_intern_atom_cookie_t atomCookies[3];
+        for (int i = 0; i < 3; i++)
+        {
+            atomCookies[i] = xcb_intern_atom(connection, 0, strlen(atomNames[i]), atomNames[i]);
+        }
+
+        RequestKeyboardMapping();
+#ifdef NOVA_HAS_XCB_XKB
+        xcb_prefetch_extension_data(connection, &xcb_xkb_id);
+#endif
+
+        window = xcb_generate_id(connection);
+        uint32_t values[] = { screen->black_pixel, XcbEventMask };
+        xcb_create_window(connection, XCB_COPY_FROM_PARENT, window, screen->root, 100, 100, width, height, 1,
+                          XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+                          XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK, values);
+
+        xcb_change_property(connection, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8,
+                            title.size(), title.c_str());
+
+        // Windows start with a fixed size until SetResizable is called
+        SetResizable(false);
+
+        xcb_atom_t *atomTargets[] = { &wmProtocols, &wmDeleteWindow, &netWmPing };
+        for (int i = 0; i < 3; i++)
+        {
+            xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(connection, atomCookies[i], nullptr);
+            if (reply != nullptr)
+            {
+                *atomTargets[i] = reply->atom;
+                free(reply);
+            }
+        }
+
+        xcb_atom_t protocols[] = { wmDeleteWindow, netWmPing };
+        xcb_change_property(connection, XCB_PROP_MODE_REPLACE, window, wmProtocols, XCB_ATOM_ATOM, 32, 2, protocols);
+
+        xcb_map_window(connection, window);
+
+        // Requested together with the atoms, so this reply arrived in the same round trip
+        xcb_get_keyboard_mapping_reply_t *mapping = xcb_get_keyboard_mapping_reply(connection, mappingCookie, nullptr);
+        mappingRequested = false;
+        if (mapping != nullptr)
+        {
+            ApplyKeyboardMapping(mapping);
+            free(mapping);
+        }
+
+        RequestDetectableAutoRepeat();
+
+        xcb_flush(connection);
+        return true;
+    }
+
+    void XcbBackend::RequestDetectableAutoRepeat()
+    {
+#ifdef NOVA_HAS_XCB_XKB
+        // Prefetched with the atoms. Requests of an extension the server lacks would close the connection.
+        const xcb_query_extension_reply_t *xkb = xcb_get_extension_data(connection, &xcb_xkb_id);
+        if (xkb == nullptr || !xkb->present)
+        {
+            Flux::Info("XKB not supported, matching repeat releases instead");
+            return;
+        }
+
+        xcb_xkb_use_extension_cookie_t useCookie =
+            xcb_xkb_use_extension(connection, XCB_XKB_MAJOR_VERSION, XCB_XKB_MINOR_VERSION);
+        xcb_discard_reply(connection, useCookie.sequence);
+
+        autoRepeatCookie = xcb_xkb_per_client_flags(connection, XCB_XKB_ID_USE_CORE_KBD,
+                                                    XCB_XKB_PER_CLIENT_FLAG_DETECTABLE_AUTO_REPEAT,
+                                                    XCB_XKB_PER_CLIENT_FLAG_DETECTABLE_AUTO_REPEAT, 0, 0, 0);
+        autoRepeatRequested = true;
+#endif
+    }
+
+    void XcbBackend::PollDetectableAutoRepeat()
+    {
+#ifdef NOVA_HAS_XCB_XKB
+        if (!autoRepeatRequested)
+        {
+            return;
+        }
+
+        xcb_xkb_per_client_flags_reply_t *reply = nullptr;
+        xcb_generic_error_t *error = nullptr;
+        if (xcb_poll_for_reply(connection, autoRepeatCookie.sequence, reinterpret_cast<void **>(&reply), &error))
+        {
+            autoRepeatRequested = false;
+            detectableAutoRepeat = reply != nullptr && (reply->value & XCB_XKB_PER_CLIENT_FLAG_DETECTABLE_AUTO_REPEAT);
+            if (!detectableAutoRepeat)
+            {
+                Flux::Info("XKB detectable auto-repeat not supported, matching repeat releases instead");
+            }
+            free(reply);
+            free(error);
+        }
+#endif
+    }
+
+    void XcbBackend::RequestKeyboardMapping()
+    {
+        if (mappingRequested)
+        {
+            // The outstanding reply describes the old mapping
+            xcb_discard_reply(connection, mappingCookie.sequence);
+        }
+
+        const xcb_setup_t *setup = xcb_get_setup(connection);
+        mappingCookie = xcb_get_keyboard_mapping(connection, setup->min_keycode,
+                                                 setup->max_keycode - setup->min_keycode + 1);
+        mappingRequested = true;
+    }
+
+    void XcbBackend::ApplyKeyboardMapping(xcb_get_keyboard_mapping_reply_t *reply)
+    {
+        keycodeTable.fill(Key::KEY_UNKNOWN);
+
+        int keysymsPerKeycode = reply->keysyms_per_keycode;
+        if (keysymsPerKeycode == 0)
+        {
+            return;
+        }
+
+        const xcb_keysym_t *keysyms = xcb_get_keyboard_mapping_keysyms(reply);
+        int count = xcb_get_keyboard_mapping_keysyms_length(reply) / keysymsPerKeycode;
+        int minKeycode = xcb_get_setup(connection)->min_keycode;
+
+        for (int i = 0; i < count && minKeycode + i < 256; i++)
+        {
+            // Same rule as the Xlib backend, the first level that names a known key wins
+            const xcb_keysym_t *levels = keysyms + i * keysymsPerKeycode;
+            for (int level = 0; level < keysymsPerKeycode; level++)
+            {
+                Key key = X11KeySymToNovaKey(levels[level]);
+                if (key != Key::KEY_UNKNOWN)
+                {
+                    keycodeTable[minKeycode + i] = key;
+                    break;
+                }
+            }
+        }
+    }
+
+    bool XcbBackend::PollEvents()
+    {
+        if (mappingRequested)
+        {
+            xcb_get_keyboard_mapping_reply_t *reply = nullptr;
+            xcb_generic_error_t *error = nullptr;
+            if (xcb_poll_for_reply(connection, mappingCookie.sequence, reinterpret_cast<void **>(&reply), &error))
+            {
+                mappingRequested = false;
+                if (reply != nullptr)
+                {
+                    ApplyKeyboardMapping(reply);
+                }
+                free(reply);
+                free(error);
+            }
+        }
+
+        PollDetectableAutoRepeat();
+
+        batch.clear();
+        bool releaseWasHeld = heldRelease;
+        heldRelease = false;
+        if (heldEvent != nullptr)
+        {
+            batch.push_back(heldEvent);
+            heldEvent = nullptr;
+        }
+
+        // Only the first call reads from the socket, the rest drain what that read brought in
+        xcb_generic_event_t *event = xcb_poll_for_event(connection);
+        while (event != nullptr)
+        {
+            batch.push_back(event);
+            event = xcb_poll_for_queued_event(connection);
+        }
+
+        // The press of a repeat can arrive in the next read. A trailing release waits for one more
+        // poll, but only once, so a real release is delivered by the next poll at the latest.
+        bool onlyHeldRelease = releaseWasHeld && batch.size() == 1;
+        if (!detectableAutoRepeat && !onlyHeldRelease && !batch.empty() &&
+            (batch.back()->response_type & ~0x80) == XCB_KEY_RELEASE)
+        {
+            heldEvent = batch.back();
+            heldRelease = true;
+            batch.pop_back();
+        }
+
+        auto hostTime = std::chrono::steady_clock::now();
+
+        bool open = xcb_connection_has_error(connection) == 0;
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            if (open && !ProcessEvent(i, hostTime))
+            {
+                open = false;
+            }
+            free(batch[i]);
+        }
+        batch.clear();
+
+        // Warps and ping replies queued while translating
+        xcb_flush(connection);
+        return open;
+    }
+
+    bool XcbBackend::IsRepeatRelease(size_t index) const
+    {
+        // Without XKB a repeat is a release followed by a press of the same key at the same time
+        if (detectableAutoRepeat || index + 1 >= batch.size() || (batch[index + 1]->response_type & ~0x80) != XCB_KEY_PRESS)
+        {
+            return false;
+        }
+
+        const xcb_key_release_event_t *release = reinterpret_cast<const xcb_key_release_event_t *>(batch[index]);
+        const xcb_key_press_event_t *press = reinterpret_cast<const xcb_key_press_event_t *>(batch[index + 1]);
+        return press->detail == release->detail && press->time == release->time;
+    }
+
+    bool XcbBackend::ProcessEvent(size_t index, std::chrono::steady_clock::time_point hostTime)
+    {
+        xcb_generic_event_t *event = batch[index];
+
+        switch (event->response_type & ~0x80)
+        {
+        case XCB_KEY_PRESS:
+        {
+            xcb_key_press_event_t *press = reinterpret_cast<xcb_key_press_event_t *>(event);
+            Key key = keycodeTable[press->detail];
+
+            if (key != Key::KEY_UNKNOWN)
+            {
+                KeyDownEvent keyDownEvent;
+                keyDownEvent.key = key;
+                keyDownEvent.modifiers = ModifiersFromCoreMask(press->state);
+                keyDownEvent.shift = HasModifier(keyDownEvent.modifiers, Modifier::Shift);
+                keyDownEvent.serverTime = press->time;
+                keyDownEvent.hostTime = hostTime;
+                owner.DispatchEvent(keyDownEvent);
+            }
+            break;
+        }
+
+        case XCB_KEY_RELEASE:
+        {
+            xcb_key_release_event_t *release = reinterpret_cast<xcb_key_release_event_t *>(event);
+            Key key = keycodeTable[release->detail];
+
+            if (key != Key::KEY_UNKNOWN && !IsRepeatRelease(index))
+            {
+                KeyUpEvent keyUpEvent;
+                keyUpEvent.key = key;
+                keyUpEvent.modifiers = ModifiersFromCoreMask(release->state);
+                keyUpEvent.shift = HasModifier(keyUpEvent.modifiers, Modifier::Shift);
+                keyUpEvent.serverTime = release->time;
+                keyUpEvent.hostTime = hostTime;
+                owner.DispatchEvent(keyUpEvent);
+            }
+            break;
+        }
+
+        case XCB_MOTION_NOTIFY:
+        {
+            xcb_motion_notify_event_t *motion = reinterpret_cast<xcb_motion_notify_event_t *>(event);
+
+            MouseMoveEvent mouseMoveEvent;
+            mouseMoveEvent.serverTime = motion->time;
+            mouseMoveEvent.hostTime = hostTime;
+
+            if (cursorLocked)
+            {
+                int centerX = owner.width / 2;
+                int centerY = owner.height / 2;
+
+                int dx = motion->event_x - centerX;
+                int dy = motion->event_y - centerY;
+                if (dx == 0 && dy == 0)
+                {
+                    break;
+                }
+
+                mouseMoveEvent.x = dx;
+                mouseMoveEvent.y = dy;
+                mouseMoveEvent.relative = true;
+                mouseMoveEvent.deltaX = dx;
+                mouseMoveEvent.deltaY = dy;
+
+                // Warp back to center, flushed once the batch is done
+                xcb_warp_pointer(connection, XCB_NONE, window, 0, 0, 0, 0, centerX, centerY);
+            }
+            else
+            {
+                mouseMoveEvent.x = motion->event_x;
+                mouseMoveEvent.y = motion->event_y;
+            }
+
+            owner.DispatchEvent(mouseMoveEvent);
+            break;
+        }
+
+        case XCB_BUTTON_PRESS:
+        case XCB_BUTTON_RELEASE:
+        {
+            xcb_button_press_event_t *button = reinterpret_cast<xcb_button_press_event_t *>(event);
+
+            MouseButton mouseButton;
+            if (button->detail == XCB_BUTTON_INDEX_1)
+            {
+                mouseButton = MouseButton::Left;
+            }
+            else if (button->detail == XCB_BUTTON_INDEX_2)
+            {
+                mouseButton = MouseButton::Middle;
+            }
+            else if (button->detail == XCB_BUTTON_INDEX_3)
+            {
+                mouseButton = MouseButton::Right;
+            }
+            else if (button->detail == 8)
+            {
+                mouseButton = MouseButton::Back;
+            }
+            else if (button->detail == 9)
+            {
+                mouseButton = MouseButton::Forward;
+            }
+            else
+            {
+                // Buttons 4 to 7 are wheel clicks up, down, left and right, only the press counts
+                if (button->detail >= XCB_BUTTON_INDEX_4 && button->detail <= XCB_BUTTON_INDEX_5 + 2 &&
+                    (event->response_type & ~0x80) == XCB_BUTTON_PRESS)
+                {
+                    MouseScrollEvent scrollEvent;
+                    scrollEvent.deltaY = button->detail == XCB_BUTTON_INDEX_4 ? 1.0 : button->detail == XCB_BUTTON_INDEX_5 ? -1.0 : 0.0;
+                    scrollEvent.deltaX = button->detail == XCB_BUTTON_INDEX_5 + 1 ? -1.0 : button->detail == XCB_BUTTON_INDEX_5 + 2 ? 1.0 : 0.0;
+                    scrollEvent.serverTime = button->time;
+                    scrollEvent.hostTime = hostTime;
+                    owner.DispatchEvent(scrollEvent);
+                }
+                break;
+            }
+
+            if ((event->response_type & ~0x80) == XCB_BUTTON_PRESS)
+            {
+                MouseButtonDownEvent mouseDownEvent;
+                mouseDownEvent.button = mouseButton;
+                mouseDownEvent.serverTime = button->time;
+                mouseDownEvent.hostTime = hostTime;
+                owner.DispatchEvent(mouseDownEvent);
+            }
+            else
+            {
+                MouseButtonUpEvent mouseUpEvent;
+                mouseUpEvent.button = mouseButton;
+                mouseUpEvent.serverTime = button->time;
+                mouseUpEvent.hostTime = hostTime;
+                owner.DispatchEvent(mouseUpEvent);
+            }
+            break;
+        }
+
+        case XCB_CLIENT_MESSAGE:
+        {
+            xcb_client_message_event_t *message = reinterpret_cast<xcb_client_message_event_t *>(event);
+            if (message->type != wmProtocols)
+            {
+                break;
+            }
+
+            if (message->data.data32[0] == wmDeleteWindow)
+            {
+                return false;
+            }
+
+            if (message->data.data32[0] == netWmPing)
+            {
+                // Answer by sending the message back to the root window
+                xcb_client_message_event_t reply = *message;
+                reply.response_type = XCB_CLIENT_MESSAGE;
+                reply.window = screen->root;
+                xcb_send_event(connection, 0, screen->root,
+                               XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT,
+                               reinterpret_cast<const char *>(&reply));
+            }
+            break;
+        }
+
+        case XCB_CONFIGURE_NOTIFY:
+        {
+            xcb_configure_notify_event_t *configure = reinterpret_cast<xcb_configure_notify_event_t *>(event);
+
+            // Window coalesces bursts of these into one WindowResizeEvent per poll
+            WindowResizeEvent resizeEvent;
+            resizeEvent.width = configure->width;
+            resizeEvent.height = configure->height;
+            resizeEvent.hostTime = hostTime;
+            owner.DispatchEvent(resizeEvent);
+            break;
+        }
+
+        case XCB_MAPPING_NOTIFY:
+        {
+            xcb_mapping_notify_event_t *mapping = reinterpret_cast<xcb_mapping_notify_event_t *>(event);
+            if (mapping->request == XCB_MAPPING_KEYBOARD)
+            {
+                RequestKeyboardMapping();
+            }
+            break;
+        }
+        }
+
+        return true;
+    }
+
+    void XcbBackend::SetResizable(bool resizable)
+    {
+        // WM_SIZE_HINTS is 18 CARD32: flags, x, y, width, height, min size, max size, ...
+        uint32_t sizeHints[18] = {};
+        if (resizable)
+        {
+            sizeHints[0] = SizeHintMinSize;
+            sizeHints[5] = 1;
+            sizeHints[6] = 1;
+        }
+        else
+        {
+            sizeHints[0] = SizeHintMinSize | SizeHintMaxSize;
+            sizeHints[5] = sizeHints[7] = owner.width;
+            sizeHints[6] = sizeHints[8] = owner.height;
+        }
+
+        xcb_change_property(connection, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_NORMAL_HINTS,
+                            XCB_ATOM_WM_SIZE_HINTS, 32, 18, sizeHints);
+        xcb_flush(connection);
+    }
+
+    bool XcbBackend::HasPendingInput()
+    {
+        if (heldEvent == nullptr)
+        {
+            // xcb has no peek, so the event is kept for the next PollEvents
+            heldEvent = xcb_poll_for_queued_event(connection);
+        }
+        return heldEvent != nullptr;
+    }
+
+    void XcbBackend::WaitForInput(const struct timespec *timeout, int wakeFd, int deviceFd)
+    {
+        xcb_flush(connection);
+
+        struct pollfd fds[3];
+        fds[0].fd = xcb_get_file_descriptor(connection);
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = wakeFd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        fds[2].fd = deviceFd;
+        fds[2].events = POLLIN;
+        fds[2].revents = 0;
+
+        if (ppoll(fds, 3, timeout, nullptr) < 0 && errno != EINTR)
+        {
+            Flux::Error("Waiting for events failed: {}", errno);
+            return;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            uint64_t value;
+            ssize_t result = read(wakeFd, &value, sizeof(value));
+            (void)result;
+        }
+    }
+
+    void XcbBackend::LockCursor()
+    {
+        if (cursorLocked)
+        {
+            return;
+        }
+
+        // Invisible cursor from a cleared 1x1 bitmap, none of these requests has a reply
+        xcb_pixmap_t pixmap = xcb_generate_id(connection);
+        xcb_create_pixmap(connection, 1, pixmap, window, 1, 1);
+
+        xcb_gcontext_t gc = xcb_generate_id(connection);
+        uint32_t foreground = 0;
+        xcb_create_gc(connection, gc, pixmap, XCB_GC_FOREGROUND, &foreground);
+        xcb_rectangle_t rectangle = { 0, 0, 1, 1 };
+        xcb_poly_fill_rectangle(connection, pixmap, gc, 1, &rectangle);
+        xcb_free_gc(connection, gc);
+
+        invisibleCursor = xcb_generate_id(connection);
+        xcb_create_cursor(connection, invisibleCursor, pixmap, pixmap, 0, 0, 0, 0, 0, 0, 0, 0);
+        xcb_free_pixmap(connection, pixmap);
+
+        xcb_change_window_attributes(connection, window, XCB_CW_CURSOR, &invisibleCursor);
+
+        xcb_grab_pointer_cookie_t grab = xcb_grab_pointer(connection, 0, window,
+                                                          XCB_EVENT_MASK_POINTER_MOTION |
+                                                              XCB_EVENT_MASK_BUTTON_PRESS |
+                                                              XCB_EVENT_MASK_BUTTON_RELEASE,
+                                                          XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC,
+                                                          window, XCB_NONE, XCB_CURRENT_TIME);
+
+        // Move to center
+        xcb_warp_pointer(connection, XCB_NONE, window, 0, 0, 0, 0, owner.width / 2, owner.height / 2);
+
+        // The only round trip, everything above was sent with it
+        xcb_grab_pointer_reply_t *reply = xcb_grab_pointer_reply(connection, grab, nullptr);
+        if (reply == nullptr || reply->status != XCB_GRAB_STATUS_SUCCESS)
+        {
+            Flux::Error("Unable to grab the pointer");
+        }
+        free(reply);
+
+        cursorLocked = true;
+    }
+
+    void XcbBackend::UnlockCursor()
+    {
+        if (!cursorLocked)
+        {
+            return;
+        }
+
+        xcb_ungrab_pointer(connection, XCB_CURRENT_TIME);
+
+        uint32_t cursor = XCB_NONE;
+        xcb_change_window_attributes(connection, window, XCB_CW_CURSOR, &cursor);
+        xcb_free_cursor(connection, invisibleCursor);
+        xcb_flush(connection);
+
+        cursorLocked = false;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+#ifdef NOVA_HAS_XCB
+#include <Nova/Event.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <xcb/xcb.h>
+#ifdef NOVA_HAS_XCB_XKB
+#include <xcb/xkb.h>
+#endif
+
+namespace Nova
+{
+    class Window;
+
+    /// @brief X11 window on top of xcb. Requests are pipelined and their replies collected
+    /// afterwards, so creating the window and locking the cursor each take one round trip.
+    class XcbBackend
+    {
+    private:
+        Window &owner;
+
+        xcb_connection_t *connection = nullptr;
+        xcb_screen_t *screen = nullptr;
+        xcb_window_t window = 0;
+
+        xcb_atom_t wmProtocols = 0;
+        xcb_atom_t wmDeleteWindow = 0;
+        xcb_atom_t netWmPing = 0;
+
+        std::array<Key, 256> keycodeTable{};
+
+        // Sent on MappingNotify, picked up by a later PollEvents instead of blocking on the reply
+        bool mappingRequested = false;
+        xcb_get_keyboard_mapping_cookie_t mappingCookie{};
+
+        bool cursorLocked = false;
+        xcb_cursor_t invisibleCursor = 0;
+
+        // With XKB detectable auto-repeat the server sends no release between repeated presses.
+        // Requested in Create, the reply is picked up by a later PollEvents.
+        bool detectableAutoRepeat = false;
+#ifdef NOVA_HAS_XCB_XKB
+        bool autoRepeatRequested = false;
+        xcb_xkb_per_client_flags_cookie_t autoRepeatCookie{};
+#endif
+
+        // One batch of events, drained before it is translated so a release can be matched with
+        // the press that follows it. A release that ends a batch is held for the next one, the
+        // press of a repeat may not have been read yet.
+        std::vector<xcb_generic_event_t *> batch;
+        xcb_generic_event_t *heldEvent = nullptr;
+        bool heldRelease = false;
+
+        void RequestKeyboardMapping();
+        void RequestDetectableAutoRepeat();
+        void PollDetectableAutoRepeat();
+        void ApplyKeyboardMapping(xcb_get_keyboard_mapping_reply_t *reply);
+
+        bool IsRepeatRelease(size_t index) const;
+        bool ProcessEvent(size_t index, std::chrono::steady_clock::time_point hostTime);
+
+    public:
+        explicit XcbBackend(Window &owner);
+        ~XcbBackend();
+
+        XcbBackend(const XcbBackend &) = delete;
+        XcbBackend &operator=(const XcbBackend &) = delete;
+
+        /// @brief Connects and maps the window, returns false if no X server is reachable
+        bool Create(const std::string &title, int width, int height);
+
+        /// @brief Translates every queued event, returns false once the window was closed
+        bool PollEvents();
+
+        /// @brief True if xcb already read an event that PollEvents would translate
+        bool HasPendingInput();
+
+        /// @brief Sleeps until the server sends something, wakeFd becomes readable or the timeout passes
+        void WaitForInput(const struct timespec *timeout, int wakeFd, int deviceFd);
+
+        void LockCursor();
+        void UnlockCursor();
+
+        void SetResizable(bool resizable);
+
+        /// @brief Connection and window as passed to vkCreateXcbSurfaceKHR
+        xcb_connection_t *GetConnection() const { return connection; }
+        xcb_window_t GetWindow() const { return window; }
+    };
+}
+#endif
@@ -4,12 +4,20 @@
 int main() {
     Flux::Info("Creating window...");
     Nova::Window window("Test", 1280, 720);
+    if (!window.IsValid()) {
+        return 1;
+    }
     
-    Flux::Info("Getting platform data...");
-    Nova::X11PlatformData* platformData = (Nova::X11PlatformData*)window.platformData;
+    Flux::Info("Getting native handles...");
+    Nova::NativeHandles handles = window.GetNativeHandles();
+    Nova::X11Handles* x11 = std::get_if<Nova::X11Handles>(&handles);
+    if (x11 == nullptr) {
+        Flux::Error("Rune is initialized from X11 handles, run the sample with NOVA_BACKEND=x11");
+        return 1;
+    }
     
     Flux::Info("Initializing Rune...");
-    Rune::Initialize(platformData->display, static_cast<uint32_t>(platformData->window), 1280, 720, false);
+    Rune::Initialize(x11->display, static_cast<uint32_t>(x11->window), 1280, 720, false);
     
     Flux::Info("Start main loop");
     int i = 0;
@@ -19,9 +27,8 @@ int main() {
     Flux::Info("First PollEvents returned: {}", shouldContinue);
     
     while (window.PollEvents()) {
-        while (window.HasEvents())
+        while (window.PopEvent())
         {
-            window.PopEvent();
         }
         Flux::Info("Frame: {}", i);
         i++;
@@ -0,0 +1,152 @@
+// Headless checks for the parts of the event path that benchmarks can't cover. Every case runs
+// without a display server and the process exits with 1 if one fails, so CI can run it through ctest.
+#include <Nova/Nova.hpp>
+#include <Flux/Flux.hpp>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+static bool failed = false;
+
+static void Check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        Flux::Error("Check failed: {}", what);
+        failed = true;
+    }
+}
+
+/// @brief Creates an empty file under /tmp and returns its path, removed again by the caller
+static std::string TemporaryFile()
+{
+    char path[] = "/tmp/NovaTestsXXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1)
+    {
+        return "";
+    }
+    close(fd);
+    return path;
+}
+
+// A listener that stops the replay runs inside ReplayEvents, which must not touch the replayer afterwards
+static void TestStopReplayFromListener()
+{
+    std::string path = TemporaryFile();
+    Check(!path.empty(), "temporary input log created");
+
+    Nova::Window window("NovaTests", 640, 480, Nova::Backend::Headless);
+    Check(window.StartRecording(path), "recording started");
+
+    for (Key key : { Key::KEY_A, Key::KEY_B, Key::KEY_C })
+    {
+        Nova::KeyDownEvent down;
+        down.key = key;
+        window.InjectEvent(down);
+
+        Nova::KeyUpEvent up;
+        up.key = key;
+        window.InjectEvent(up);
+    }
+
+    window.PollEvents();
+    while (window.PopEvent())
+    {
+    }
+    window.StopRecording();
+
+    Check(window.StartReplay(path, Nova::ReplaySpeed::Fast), "replay started");
+
+    int downs = 0;
+    auto onDown = [&](const Nova::KeyDownEvent &)
+    {
+        downs++;
+        window.StopReplay();
+    };
+    window.On<Nova::KeyDownEvent>(onDown);
+
+    window.PollEvents();
+    while (window.PopEvent())
+    {
+    }
+
+    Check(downs == 1, "no replayed presses after StopReplay");
+    Check(!window.IsReplaying(), "replay stopped once the poll returned");
+
+    window.PollEvents();
+    unlink(path.c_str());
+}
+
+// Included after every use of Nova::Key, its KEY_* macros collide with it
+#include <linux/input.h>
+
+static void WriteInputEvent(int fd, uint16_t type, uint16_t code, int32_t value)
+{
+    input_event record = {};
+    record.type = type;
+    record.code = code;
+    record.value = value;
+    ssize_t written = write(fd, &record, sizeof(record));
+    (void)written;
+}
+
+// A gamepad listener that disables gamepads runs inside the manager's poll, which has to outlive it
+static void TestDisableGamepadsFromListener()
+{
+    std::string path = TemporaryFile();
+    Check(!path.empty(), "temporary gamepad file created");
+
+    int fd = open(path.c_str(), O_WRONLY | O_TRUNC);
+    WriteInputEvent(fd, EV_KEY, BTN_SOUTH, 1);
+    WriteInputEvent(fd, EV_SYN, SYN_REPORT, 0);
+    WriteInputEvent(fd, EV_KEY, BTN_SOUTH, 0);
+    WriteInputEvent(fd, EV_SYN, SYN_REPORT, 0);
+    close(fd);
+
+    Nova::Window window("NovaTests", 640, 480, Nova::Backend::Headless);
+    int slot = window.OpenGamepad(path);
+    Check(slot >= 0, "recorded gamepad opened");
+
+    int downs = 0;
+    int ups = 0;
+    auto onDown = [&](const Nova::GamepadButtonDownEvent &)
+    {
+        downs++;
+        window.DisableGamepads();
+    };
+    auto onUp = [&](const Nova::GamepadButtonUpEvent &) { ups++; };
+    int disconnects = 0;
+    auto onDisconnect = [&](const Nova::GamepadDisconnectedEvent &event) { disconnects += event.gamepad == slot; };
+    window.On<Nova::GamepadButtonDownEvent>(onDown);
+    window.On<Nova::GamepadButtonUpEvent>(onUp);
+    window.On<Nova::GamepadDisconnectedEvent>(onDisconnect);
+
+    window.PollEvents();
+    while (window.PopEvent())
+    {
+    }
+
+    Check(downs == 1, "button press delivered once");
+    Check(ups == 0, "no gamepad events after DisableGamepads");
+    Check(!window.IsGamepadConnected(slot), "gamepads closed once the poll returned");
+    Check(disconnects == 1, "open gamepad announced as disconnected");
+
+    window.PollEvents();
+    unlink(path.c_str());
+}
+
+int main()
+{
+    TestDisableGamepadsFromListener();
+    TestStopReplayFromListener();
+
+    if (failed)
+    {
+        return 1;
+    }
+
+    Flux::Info("All checks passed");
+    return 0;
+}